@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <SFML/System.hpp>
+#include "constants.hpp"
+#include "Controls.hpp"
+#include "engine/threading/WorkerPool.hpp"
+#include "Game.hpp"
+
+/**
+ * Hosts many independent games and steps them in lockstep across a
+ * worker pool, e.g for bot training and load tests.
+ *
+ * Each game owns its world, state machine and random engine, and nothing
+ * mutable is shared between them, so every game is stepped by a single
+ * task without any locking.
+ */
+class BatchSimulation {
+ public:
+    /**
+     * Creates `gameCount` games of the given level, seeding the i-th one
+     * with `firstSeed + i`.
+     */
+    BatchSimulation(
+        const LevelConfig& level,
+        std::size_t gameCount,
+        unsigned firstSeed,
+        unsigned threadCount
+    );
+
+    std::size_t size() const;
+
+    /**
+     * Runs `ticks` ticks of every game, feeding `controls[i]` to the i-th
+     * game on every tick.
+     */
+    void step(const std::vector<Controls>& controls, unsigned ticks = 1);
+
+    /**
+     * Gives access to the results of a game. Must not be called
+     * during a `step`.
+     */
+    Game& getGame(std::size_t index);
+
+ private:
+    // Games are never moved, since their states keep references into them
+    std::vector<std::unique_ptr<Game>> games;
+    threading::WorkerPool pool;
+    sf::Time tickDuration = sf::microseconds(1000000 / constants::TICK_RATE);
+};
+
+inline BatchSimulation::BatchSimulation(
+    const LevelConfig& level,
+    std::size_t gameCount,
+    unsigned firstSeed,
+    unsigned threadCount
+) : games(gameCount), pool(threadCount) {
+    pool.parallelFor(gameCount, [this, &level, firstSeed](std::size_t i) {
+        games[i] = std::make_unique<Game>();
+        games[i]->init(level, firstSeed + i);
+    });
+}
+
+inline std::size_t BatchSimulation::size() const {
+    return games.size();
+}
+
+inline void BatchSimulation::step(const std::vector<Controls>& controls, unsigned ticks) {
+    pool.parallelFor(games.size(), [this, &controls, ticks](std::size_t i) {
+        Game& game = *games[i];
+
+        for (unsigned tick = 0; tick < ticks; tick++) {
+            game.update(tickDuration, controls[i]);
+        }
+    });
+}
+
+inline Game& BatchSimulation::getGame(std::size_t index) {
+    return *games[index];
+}
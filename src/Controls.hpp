@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+/**
+ * The player commands for a single tick. The windowed game builds them
+ * from timestamped keyboard events, while headless runs script them, so
+ * that no system needs to poll the input devices directly.
+ */
+struct Controls {
+    /**
+     * Resolution of `travel`, in steps per tick.
+     */
+    static constexpr int TRAVEL_STEPS = 64;
+
+    bool left = false;
+    bool right = false;
+    bool launch = false;
+
+    /**
+     * Net movement of the paddle during the tick, in 1/`TRAVEL_STEPS` of
+     * a whole tick of movement, negative to the left. Set when the keys
+     * were pressed or released in the middle of the tick; without it, the
+     * paddle moves towards left or right for the whole tick.
+     */
+    std::optional<std::int8_t> travel;
+};
@@ -1,29 +1,67 @@
 #pragma once
 
 #include <memory>
-#include <SFML/Graphics.hpp>
+#include <random>
+#include <SFML/System.hpp>
+#include "Controls.hpp"
 #include "engine-glue/ecs.hpp"
+#include "engine/logging/Logger.hpp"
+#include "engine/rendering/Backend.hpp"
 #include "engine/state-management/StateMachine.hpp"
+#include "LevelPreparation.hpp"
 #include "states/RunningState.hpp"
 #include "states/WaitingState.hpp"
 
 class Game {
  public:
-    void init(float width, float height) {
-        stateMachine.registerState("waiting", std::make_unique<WaitingState>(world, stateMachine));
-        stateMachine.registerState("running", std::make_unique<RunningState>(world, stateMachine));
+    /**
+     * Sets the game up to play the given level. Preparing the level in
+     * the background takes a thread per game, so it is meant for the
+     * windowed game, where swapping the next level in must not stall a
+     * frame.
+     */
+    void init(
+        const LevelConfig& levelConfig,
+        unsigned seed = std::mt19937::default_seed,
+        LevelPreparation::Mode preparation = LevelPreparation::Mode::Synchronous
+    ) {
+        level = levelConfig;
+        world.randomEngine().seed(seed);
+        stateMachine.registerState("waiting", std::make_unique<WaitingState>(world, stateMachine, controls, level, preparation));
+        stateMachine.registerState("running", std::make_unique<RunningState>(world, stateMachine, controls));
         stateMachine.pushState("waiting");
     }
 
-    void update(const sf::Time& elapsedTime) {
+    void update(const sf::Time& elapsedTime, const Controls& tickControls) {
+        PROFILE_SCOPE("Game::update");
+
+        // Systems may log, and must not allocate a ring when they first do
+        LOG_REGISTER_THREAD();
+
+        controls = tickControls;
         stateMachine.getState().update(elapsedTime);
     }
 
-    void render(sf::RenderWindow& window) {
-        stateMachine.getState().render(window);
+    void extract(rendering::CommandList& commandList, float interpolation = 1) {
+        PROFILE_SCOPE("Game::extract");
+
+        commandList.clear();
+        stateMachine.getState().render(commandList, interpolation);
+    }
+
+    ecs::World& getWorld() {
+        return world;
+    }
+
+    rendering::DrawStats render(rendering::Backend& backend, float interpolation = 1) {
+        extract(commandList, interpolation);
+        return backend.draw(commandList);
     }
 
  private:
     ecs::World world;
     state::StateMachine stateMachine;
+    rendering::CommandList commandList;
+    Controls controls;
+    LevelConfig level;
 };
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <SFML/System.hpp>
+#include "Controls.hpp"
+
+/**
+ * Key events stamped with the time they were received, turned into the
+ * `Controls` of each fixed tick.
+ *
+ * A tick covers an interval of the same clock as the events. The events
+ * inside it are applied where they happened, so the paddle only travels
+ * for the part of the tick during which a direction was held, and short
+ * presses within a tick still launch or move. Events older than the tick
+ * count as happening at its start, and newer ones stay queued.
+ */
+class InputQueue {
+ public:
+    enum Key {
+        LEFT,
+        RIGHT,
+        LAUNCH,
+    };
+
+    void push(const sf::Time& timestamp, Key, bool pressed);
+
+    /**
+     * Releases all keys, e.g when the window loses focus and stops
+     * receiving their events.
+     */
+    void releaseAll(const sf::Time& timestamp);
+
+    /**
+     * Consumes the events before `tickEnd` and returns the controls of the
+     * tick that started at `tickStart`.
+     */
+    Controls take(const sf::Time& tickStart, const sf::Time& tickEnd);
+
+ private:
+    struct Event {
+        sf::Time timestamp;
+        Key key;
+        bool pressed;
+    };
+
+    std::deque<Event> events;
+    bool held[3] = { false, false, false };
+
+    float direction() const;
+};
+
+inline void InputQueue::push(const sf::Time& timestamp, Key key, bool pressed) {
+    events.push_back({ timestamp, key, pressed });
+}
+
+inline void InputQueue::releaseAll(const sf::Time& timestamp) {
+    for (Key key : { LEFT, RIGHT, LAUNCH }) {
+        push(timestamp, key, false);
+    }
+}
+
+inline Controls InputQueue::take(const sf::Time& tickStart, const sf::Time& tickEnd) {
+    bool launched = held[LAUNCH];
+    bool changed = false;
+    float travel = 0;
+    sf::Time segmentStart = tickStart;
+
+    while (!events.empty() && events.front().timestamp < tickEnd) {
+        const Event& event = events.front();
+        sf::Time at = std::max(event.timestamp, tickStart);
+
+        travel += direction() * (at - segmentStart).asMicroseconds();
+        segmentStart = at;
+
+        changed |= held[event.key] != event.pressed && event.key != LAUNCH;
+        held[event.key] = event.pressed;
+        launched |= held[LAUNCH];
+
+        events.pop_front();
+    }
+
+    travel += direction() * (tickEnd - segmentStart).asMicroseconds();
+
+    Controls controls;
+    controls.left = held[LEFT];
+    controls.right = held[RIGHT];
+    controls.launch = launched;
+
+    // Ticks without direction changes move as the held keys say, exactly
+    if (changed) {
+        float ticks = travel / (tickEnd - tickStart).asMicroseconds();
+        controls.travel = static_cast<std::int8_t>(std::lround(ticks * Controls::TRAVEL_STEPS));
+    }
+
+    return controls;
+}
+
+/**
+ * The paddle direction for the held keys, with left taking precedence as
+ * in the input system.
+ */
+inline float InputQueue::direction() const {
+    return held[LEFT] ? -1 : (held[RIGHT] ? 1 : 0);
+}
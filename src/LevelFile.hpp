@@ -0,0 +1,344 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "engine-glue/ecs.hpp"
+#include "engine/memory/MappedFile.hpp"
+
+/**
+ * Fixed-size header of a level file.
+ *
+ * Binary layout (little-endian, in the memory layout of the components so
+ * that columns can be ingested without parsing):
+ * - this header, starting with the "ARKL" magic and a uint32 format version
+ * - the palette of the tile map: `paletteSize` Styles
+ * - the cells of the tile map: `tileColumns * tileRows` TileCells
+ * - the static entities as columns of `entityCount` Positions, Rectangles,
+ *   Styles and `LevelFile::Tags` bitfields
+ *
+ * Every section starts at a multiple of `LevelFile::ALIGNMENT`, given by
+ * its offset in the header. A level without a tile map has 0 rows.
+ */
+struct LevelFileHeader {
+    char magic[4];
+    std::uint32_t version;
+    float boardWidth;
+    float boardHeight;
+    std::uint32_t brickCount;
+    std::uint32_t ballCount;
+    std::int32_t powerUpDropRate;
+    std::uint32_t layout;
+    float tileOriginX;
+    float tileOriginY;
+    float cellWidth;
+    float cellHeight;
+    std::uint32_t tileColumns;
+    std::uint32_t tileRows;
+    std::uint32_t paletteSize;
+    std::uint32_t entityCount;
+    std::uint64_t paletteOffset;
+    std::uint64_t cellsOffset;
+    std::uint64_t positionsOffset;
+    std::uint64_t rectanglesOffset;
+    std::uint64_t stylesOffset;
+    std::uint64_t tagsOffset;
+};
+
+static_assert(sizeof(LevelFileHeader) == 112);
+static_assert(sizeof(Position) == 8 && std::is_trivially_copyable_v<Position>);
+static_assert(sizeof(Rectangle) == 8 && std::is_trivially_copyable_v<Rectangle>);
+static_assert(sizeof(Style) == 12 && std::is_trivially_copyable_v<Style>);
+static_assert(sizeof(TileCell) == 2 && std::is_trivially_copyable_v<TileCell>);
+
+/**
+ * A level file mapped into memory. Only the header is validated on
+ * construction; the columns are exposed as pointers into the mapping and
+ * are paged in as they are read. The tile map cells are validated as they
+ * are copied out.
+ *
+ * Levels store the static part of the board: the brick tile map, if any,
+ * and the walls and brick entities. The paddle and balls are still created
+ * from the stored `LevelConfig`.
+ */
+class LevelFile {
+ public:
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::size_t ALIGNMENT = 16;
+
+    enum Tags : std::uint8_t {
+        BOUNCE_COLLISION = 1 << 0,
+        BRICK = 1 << 1,
+        VISIBLE = 1 << 2,
+        WALL = 1 << 3,
+    };
+
+    /**
+     * Maps the level at `path`. Throws `std::runtime_error` if it isn't
+     * a complete level file of the current version.
+     */
+    explicit LevelFile(const std::string& path);
+
+    /**
+     * Returns the configuration of the level, with `file` set to the
+     * path of this level.
+     */
+    LevelConfig config() const;
+
+    bool hasTileMap() const;
+
+    /**
+     * Returns the tile map of the level, whose cells are copied out of
+     * the file in one go. Requires `hasTileMap()`. Throws
+     * `std::runtime_error` if a cell refers to a style past the palette.
+     */
+    TileMap tileMap() const;
+
+    std::size_t entityCount() const;
+    const Position* positions() const;
+    const Rectangle* rectangles() const;
+    const Style* styles() const;
+    const std::uint8_t* tags() const;
+
+ private:
+    std::string path;
+    memory::MappedFile file;
+    LevelFileHeader header;
+    std::size_t cellCount;
+
+    void checkSection(std::uint64_t offset, std::size_t bytes) const;
+
+    template<typename T>
+    const T* column(std::uint64_t offset) const;
+};
+
+namespace levelfile {
+    namespace __detail {
+        inline std::uint64_t alignLevelOffset(std::uint64_t offset) {
+            return (offset + LevelFile::ALIGNMENT - 1) / LevelFile::ALIGNMENT * LevelFile::ALIGNMENT;
+        }
+
+        template<typename T>
+        inline void writeLevelColumn(
+            std::ostream& stream,
+            std::uint64_t& offset,
+            const std::vector<T>& column
+        ) {
+            static const char padding[LevelFile::ALIGNMENT] = { };
+            std::uint64_t start = alignLevelOffset(offset);
+            stream.write(padding, start - offset);
+
+            std::size_t bytes = column.size() * sizeof(T);
+            stream.write(reinterpret_cast<const char*>(column.data()), bytes);
+            offset = start + bytes;
+        }
+    }
+}
+
+
+inline LevelFile::LevelFile(const std::string& levelPath)
+  : path(levelPath), file(levelPath) {
+    if (file.size() < sizeof(header)) {
+        throw std::runtime_error("not a level file");
+    }
+
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::string(header.magic, 4) != "ARKL") {
+        throw std::runtime_error("not a level file");
+    }
+
+    if (header.version != VERSION) {
+        throw std::runtime_error("unsupported level version");
+    }
+
+    if (header.layout > static_cast<std::uint32_t>(BrickLayout::Clustered)) {
+        throw std::runtime_error("unknown level layout");
+    }
+
+    // Cells are indexed with unsigned ints, so the count must fit in one
+    cellCount = std::size_t(header.tileColumns) * header.tileRows;
+    std::size_t entities = header.entityCount;
+
+    if (cellCount > std::numeric_limits<unsigned>::max()) {
+        throw std::runtime_error("level tile map too large");
+    }
+
+    checkSection(header.paletteOffset, header.paletteSize * sizeof(Style));
+    checkSection(header.cellsOffset, cellCount * sizeof(TileCell));
+    checkSection(header.positionsOffset, entities * sizeof(Position));
+    checkSection(header.rectanglesOffset, entities * sizeof(Rectangle));
+    checkSection(header.stylesOffset, entities * sizeof(Style));
+    checkSection(header.tagsOffset, entities);
+}
+
+inline LevelConfig LevelFile::config() const {
+    LevelConfig level;
+    level.boardWidth = header.boardWidth;
+    level.boardHeight = header.boardHeight;
+    level.brickCount = header.brickCount;
+    level.ballCount = header.ballCount;
+    level.powerUpDropRate = header.powerUpDropRate;
+    level.layout = static_cast<BrickLayout>(header.layout);
+    level.file = path;
+
+    return level;
+}
+
+inline bool LevelFile::hasTileMap() const {
+    return header.tileRows > 0;
+}
+
+inline TileMap LevelFile::tileMap() const {
+    const Style* palette = column<Style>(header.paletteOffset);
+    const TileCell* cells = column<TileCell>(header.cellsOffset);
+
+    for (std::size_t i = 0; i < cellCount; i++) {
+        if (cells[i].style >= header.paletteSize) {
+            throw std::runtime_error("level cell style out of the palette");
+        }
+    }
+
+    return TileMap {
+        Position { header.tileOriginX, header.tileOriginY },
+        header.cellWidth,
+        header.cellHeight,
+        header.tileColumns,
+        header.tileRows,
+        std::vector<Style>(palette, palette + header.paletteSize),
+        std::vector<TileCell>(cells, cells + cellCount)
+    };
+}
+
+inline std::size_t LevelFile::entityCount() const {
+    return header.entityCount;
+}
+
+inline const Position* LevelFile::positions() const {
+    return column<Position>(header.positionsOffset);
+}
+
+inline const Rectangle* LevelFile::rectangles() const {
+    return column<Rectangle>(header.rectanglesOffset);
+}
+
+inline const Style* LevelFile::styles() const {
+    return column<Style>(header.stylesOffset);
+}
+
+inline const std::uint8_t* LevelFile::tags() const {
+    return column<std::uint8_t>(header.tagsOffset);
+}
+
+inline void LevelFile::checkSection(std::uint64_t offset, std::size_t bytes) const {
+    if (offset % ALIGNMENT != 0) {
+        throw std::runtime_error("misaligned level section");
+    }
+
+    if (offset > file.size() || bytes > file.size() - offset) {
+        throw std::runtime_error("truncated level file");
+    }
+}
+
+template<typename T>
+inline const T* LevelFile::column(std::uint64_t offset) const {
+    // The mapping is page-aligned and sections are aligned in the file
+    return reinterpret_cast<const T*>(file.data() + offset);
+}
+
+/**
+ * Writes the static part of a level built in `world` (see `LevelFile`):
+ * its `LevelConfig`, the brick tile map and every wall and brick entity.
+ */
+inline void saveLevel(std::ostream& stream, ecs::World& world) {
+    using levelfile::__detail::alignLevelOffset;
+    using levelfile::__detail::writeLevelColumn;
+
+    LevelFileHeader header { };
+    std::memcpy(header.magic, "ARKL", 4);
+    header.version = LevelFile::VERSION;
+
+    world.query<LevelConfig>([&header](ecs::Entity, const LevelConfig& level) {
+        header.boardWidth = level.boardWidth;
+        header.boardHeight = level.boardHeight;
+        header.brickCount = level.brickCount;
+        header.ballCount = level.ballCount;
+        header.powerUpDropRate = level.powerUpDropRate;
+        header.layout = static_cast<std::uint32_t>(level.layout);
+    });
+
+    std::vector<Style> palette;
+    std::vector<TileCell> cells;
+
+    world.query<TileMap>([&](ecs::Entity, const TileMap& tileMap) {
+        header.tileOriginX = tileMap.origin.x;
+        header.tileOriginY = tileMap.origin.y;
+        header.cellWidth = tileMap.cellWidth;
+        header.cellHeight = tileMap.cellHeight;
+        header.tileColumns = tileMap.columns;
+        header.tileRows = tileMap.rows;
+        palette = tileMap.palette;
+        cells = tileMap.cells;
+    });
+
+    std::vector<Position> positions;
+    std::vector<Rectangle> rectangles;
+    std::vector<Style> styles;
+    std::vector<std::uint8_t> tags;
+
+    world.query<Rectangle, Position, Style>([&](
+        ecs::Entity entity,
+        const Rectangle& body,
+        const Position& position,
+        const Style& style
+    ) {
+        bool isBrick = world.hasComponent<Brick>(entity);
+
+        if (!isBrick && !world.hasComponent<Wall>(entity)) {
+            return;
+        }
+
+        positions.push_back(position);
+        rectangles.push_back(body);
+        styles.push_back(style);
+        tags.push_back(
+            (world.hasComponent<BounceCollision>(entity) ? LevelFile::BOUNCE_COLLISION : 0)
+          | (isBrick ? LevelFile::BRICK : 0)
+          | (world.hasComponent<Visible>(entity) ? LevelFile::VISIBLE : 0)
+          | (world.hasComponent<Wall>(entity) ? LevelFile::WALL : 0)
+        );
+    });
+
+    header.paletteSize = palette.size();
+    header.entityCount = positions.size();
+
+    // Lays the sections out in the order in which they are written
+    std::uint64_t offset = sizeof(header);
+    auto place = [&offset](std::uint64_t& field, std::size_t bytes) {
+        field = alignLevelOffset(offset);
+        offset = field + bytes;
+    };
+
+    place(header.paletteOffset, palette.size() * sizeof(Style));
+    place(header.cellsOffset, cells.size() * sizeof(TileCell));
+    place(header.positionsOffset, positions.size() * sizeof(Position));
+    place(header.rectanglesOffset, rectangles.size() * sizeof(Rectangle));
+    place(header.stylesOffset, styles.size() * sizeof(Style));
+    place(header.tagsOffset, tags.size());
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    offset = sizeof(header);
+    writeLevelColumn(stream, offset, palette);
+    writeLevelColumn(stream, offset, cells);
+    writeLevelColumn(stream, offset, positions);
+    writeLevelColumn(stream, offset, rectangles);
+    writeLevelColumn(stream, offset, styles);
+    writeLevelColumn(stream, offset, tags);
+}
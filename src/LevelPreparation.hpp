@@ -0,0 +1,190 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "engine-glue/ecs.hpp"
+#include "engine/rendering/CommandList.hpp"
+#include "systems/level-loading-system/include.hpp"
+#include "systems/rendering-system/include.hpp"
+
+/**
+ * Prepares copies of a level, so that entering the level only copies or
+ * swaps the prepared copy into the world.
+ *
+ * The level is generated or decoded once, in a detached staging world,
+ * together with its render batches. Synchronously, every `swapInto` then
+ * copies it into the world.
+ *
+ * In the background, e.g for the windowed game, a thread keeps a spare
+ * copy of it ready instead: every `swapInto` hands out the spare copy in
+ * constant time and takes the previous contents of the world back, which
+ * the thread overwrites with a fresh copy, reusing their memory. Some of
+ * it is kept by the world instead, for the components added while playing.
+ * Both ways give the same level.
+ */
+class LevelPreparation {
+ public:
+    enum class Mode {
+        // Built on the first `swapInto`, then copied by every one
+        Synchronous,
+        // Built and copied by a thread of its own
+        Background,
+    };
+
+    /**
+     * Starts preparing the given level. `randomEngine` is copied and only
+     * used for the level generation, so the level doesn't depend on when
+     * it is prepared.
+     */
+    LevelPreparation(
+        const LevelConfig& level,
+        const std::mt19937& randomEngine,
+        Mode mode = Mode::Synchronous
+    );
+    ~LevelPreparation();
+
+    LevelPreparation(const LevelPreparation&) = delete;
+    LevelPreparation& operator=(const LevelPreparation&) = delete;
+
+    /**
+     * Checks if a copy of the level can be swapped in without waiting.
+     */
+    bool isReady();
+
+    /**
+     * Replaces all entities of `world` with a fresh copy of the level,
+     * waiting for it if it is prepared in the background and isn't ready
+     * yet. Rethrows any exception thrown
+     * while preparing the level, e.g by a malformed level file.
+     */
+    void swapInto(ecs::World& world);
+
+ private:
+    LevelConfig level;
+    std::mt19937 randomEngine;
+    bool built = false;
+    ecs::World::Storage pristine;
+    ecs::World::Storage staging;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stagingReady = false;
+    bool stopping = false;
+    std::exception_ptr error;
+    std::thread worker;
+
+    void work();
+    void buildLevel();
+};
+
+inline LevelPreparation::LevelPreparation(
+    const LevelConfig& level,
+    const std::mt19937& randomEngine,
+    Mode mode
+) : level(level), randomEngine(randomEngine) {
+    if (mode == Mode::Background) {
+        worker = std::thread([this] { work(); });
+    }
+}
+
+inline LevelPreparation::~LevelPreparation() {
+    if (!worker.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    condition.notify_all();
+    worker.join();
+}
+
+inline bool LevelPreparation::isReady() {
+    if (!worker.joinable()) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return stagingReady;
+}
+
+inline void LevelPreparation::swapInto(ecs::World& world) {
+    PROFILE_SCOPE("LevelPreparation::swapInto");
+
+    if (!worker.joinable()) {
+        if (!built) {
+            buildLevel();
+            built = true;
+        }
+
+        // Only the spare components of the previous contents are kept, so
+        // that a game holds no more than the level and its world
+        ecs::World::Storage previous;
+        world.swapStorage(previous);
+        world.recycleStorage(previous);
+        world.restoreStorage(pristine);
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return stagingReady; });
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        world.swapStorage(staging);
+        world.recycleStorage(staging);
+        stagingReady = false;
+    }
+
+    condition.notify_all();
+}
+
+inline void LevelPreparation::work() {
+    try {
+        buildLevel();
+
+        while (true) {
+            staging = pristine;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            stagingReady = true;
+            condition.notify_all();
+            condition.wait(lock, [this] { return !stagingReady || stopping; });
+
+            if (stopping) {
+                return;
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+        stagingReady = true;
+        condition.notify_all();
+    }
+}
+
+/**
+ * Builds the level into `pristine`, including the static render batches
+ * that the rendering system would otherwise build on the first frame.
+ */
+inline void LevelPreparation::buildLevel() {
+    PROFILE_SCOPE("LevelPreparation::buildLevel");
+
+    // Worlds are large, so the staging one lives on the heap
+    auto world = std::make_unique<ecs::World>();
+    world->randomEngine() = randomEngine;
+    useLevelLoadingSystem(*world, level);
+
+    rendering::CommandList commandList;
+    useRenderingSystem(*world, commandList, 1);
+
+    world->copyStorageTo(pristine);
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "components/LevelConfig.hpp"
+#include "Controls.hpp"
+
+/**
+ * A recorded run: everything that is needed to reproduce it tick by tick,
+ * plus the world hash after every tick so that a playback can be checked.
+ *
+ * Binary layout (little-endian):
+ * - "ARKR" magic and a uint32 format version
+ * - uint32 seed of the world random engine
+ * - uint32 tick rate, in ticks per second
+ * - the `LevelConfig`: board width and height as float bits, brick count,
+ *   ball count, power-up drop rate and layout, as uint32s, followed by
+ *   the level file path as a uint32 length and its characters
+ * - uint32 number of ticks N
+ * - N bytes, one `Controls` bitfield per tick
+ * - N signed bytes, the `Controls::travel` of every tick, or 0 for ticks
+ *   without it (see `TRAVEL`)
+ * - N uint64 world hashes, one per tick
+ */
+struct Replay {
+    static constexpr std::uint32_t VERSION = 4;
+
+    enum ControlBits : std::uint8_t {
+        LEFT = 1 << 0,
+        RIGHT = 1 << 1,
+        LAUNCH = 1 << 2,
+        TRAVEL = 1 << 3,
+    };
+
+    std::uint32_t seed;
+    std::uint32_t tickRate;
+    LevelConfig level;
+    std::vector<std::uint8_t> inputs;
+    std::vector<std::int8_t> travels;
+    std::vector<std::uint64_t> hashes;
+
+    void record(const Controls& controls, std::uint64_t hash) {
+        inputs.push_back(encode(controls));
+        travels.push_back(controls.travel.value_or(0));
+        hashes.push_back(hash);
+    }
+
+    Controls controlsAt(std::size_t tick) const {
+        return decode(inputs[tick], travels[tick]);
+    }
+
+    std::size_t size() const {
+        return inputs.size();
+    }
+
+    static std::uint8_t encode(const Controls& controls) {
+        return (controls.left ? LEFT : 0)
+             | (controls.right ? RIGHT : 0)
+             | (controls.launch ? LAUNCH : 0)
+             | (controls.travel ? TRAVEL : 0);
+    }
+
+    static Controls decode(std::uint8_t bits, std::int8_t travel) {
+        Controls controls;
+        controls.left = bits & LEFT;
+        controls.right = bits & RIGHT;
+        controls.launch = bits & LAUNCH;
+
+        if (bits & TRAVEL) {
+            controls.travel = travel;
+        }
+
+        return controls;
+    }
+};
+
+namespace replayfile {
+    namespace __detail {
+        template<typename T>
+        inline void writeLittleEndian(std::ostream& stream, T value) {
+            for (std::size_t i = 0; i < sizeof(T); i++) {
+                stream.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        template<typename T>
+        inline T readLittleEndian(std::istream& stream) {
+            T value = 0;
+
+            for (std::size_t i = 0; i < sizeof(T); i++) {
+                value |= static_cast<T>(static_cast<unsigned char>(stream.get())) << (8 * i);
+            }
+
+            return value;
+        }
+
+        inline std::uint32_t floatBits(float value) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        inline float bitsToFloat(std::uint32_t bits) {
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    }
+}
+
+inline void saveReplay(std::ostream& stream, const Replay& replay) {
+    using replayfile::__detail::writeLittleEndian;
+
+    stream.write("ARKR", 4);
+    writeLittleEndian<std::uint32_t>(stream, Replay::VERSION);
+    writeLittleEndian<std::uint32_t>(stream, replay.seed);
+    writeLittleEndian<std::uint32_t>(stream, replay.tickRate);
+
+    const LevelConfig& level = replay.level;
+    writeLittleEndian(stream, replayfile::__detail::floatBits(level.boardWidth));
+    writeLittleEndian(stream, replayfile::__detail::floatBits(level.boardHeight));
+    writeLittleEndian<std::uint32_t>(stream, level.brickCount);
+    writeLittleEndian<std::uint32_t>(stream, level.ballCount);
+    writeLittleEndian<std::uint32_t>(stream, level.powerUpDropRate);
+    writeLittleEndian<std::uint32_t>(stream, static_cast<std::uint32_t>(level.layout));
+    writeLittleEndian<std::uint32_t>(stream, level.file.size());
+    stream.write(level.file.data(), level.file.size());
+
+    writeLittleEndian<std::uint32_t>(stream, replay.size());
+
+    stream.write(reinterpret_cast<const char*>(replay.inputs.data()), replay.size());
+    stream.write(reinterpret_cast<const char*>(replay.travels.data()), replay.size());
+
+    for (std::uint64_t hash : replay.hashes) {
+        writeLittleEndian(stream, hash);
+    }
+}
+
+/**
+ * Reads a replay written by `saveReplay`. Throws `std::runtime_error`
+ * if the stream doesn't contain a complete replay.
+ */
+inline Replay loadReplay(std::istream& stream) {
+    using replayfile::__detail::readLittleEndian;
+
+    char magic[4];
+    stream.read(magic, 4);
+
+    if (!stream || std::string(magic, 4) != "ARKR") {
+        throw std::runtime_error("not a replay file");
+    }
+
+    if (readLittleEndian<std::uint32_t>(stream) != Replay::VERSION) {
+        throw std::runtime_error("unsupported replay version");
+    }
+
+    Replay replay;
+    replay.seed = readLittleEndian<std::uint32_t>(stream);
+    replay.tickRate = readLittleEndian<std::uint32_t>(stream);
+
+    LevelConfig& level = replay.level;
+    level.boardWidth = replayfile::__detail::bitsToFloat(readLittleEndian<std::uint32_t>(stream));
+    level.boardHeight = replayfile::__detail::bitsToFloat(readLittleEndian<std::uint32_t>(stream));
+    level.brickCount = readLittleEndian<std::uint32_t>(stream);
+    level.ballCount = readLittleEndian<std::uint32_t>(stream);
+    level.powerUpDropRate = readLittleEndian<std::uint32_t>(stream);
+    level.layout = static_cast<BrickLayout>(readLittleEndian<std::uint32_t>(stream));
+    std::uint32_t fileLength = readLittleEndian<std::uint32_t>(stream);
+
+    if (!stream) {
+        throw std::runtime_error("truncated replay file");
+    }
+
+    level.file.resize(fileLength);
+    stream.read(level.file.data(), fileLength);
+
+    std::uint32_t ticks = readLittleEndian<std::uint32_t>(stream);
+
+    replay.inputs.resize(ticks);
+    stream.read(reinterpret_cast<char*>(replay.inputs.data()), ticks);
+
+    replay.travels.resize(ticks);
+    stream.read(reinterpret_cast<char*>(replay.travels.data()), ticks);
+
+    replay.hashes.reserve(ticks);
+    for (std::uint32_t i = 0; i < ticks; i++) {
+        replay.hashes.push_back(readLittleEndian<std::uint64_t>(stream));
+    }
+
+    if (!stream) {
+        throw std::runtime_error("truncated replay file");
+    }
+
+    return replay;
+}
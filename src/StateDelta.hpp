@@ -0,0 +1,1004 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "engine-glue/ecs.hpp"
+#include "engine/metaprogramming/for-each-type.hpp"
+
+/**
+ * The components that a viewer needs to draw the world. Tags, and the
+ * StaticLayer whose contents each viewer builds for itself, only have their
+ * presence replicated. The order gives the bit of each component in the
+ * masks of `StateDelta`.
+ */
+using ReplicatedComponents = std::tuple<
+    Position,
+    Velocity,
+    Circle,
+    Rectangle,
+    Style,
+    Link,
+    TileMap,
+    Ball,
+    Brick,
+    Paddle,
+    PowerUp,
+    Wall,
+    Visible,
+    Input,
+    StaticLayer
+>;
+
+/**
+ * Changes of the replicated components of a world between two of its
+ * snapshots: the baseline, which the viewer has acknowledged, and the
+ * current one. Only the entities of the chunks that differ between the two
+ * snapshots are compared, so the size and cost of a delta scale with what
+ * moved, not with the size of the world.
+ *
+ * Binary layout (integers as LEB128 varints, signed ones zigzag-encoded
+ * first, floats and colors as little-endian uint32s):
+ * - the server snapshot ID that the delta brings the viewer to
+ * - the ID of the baseline plus one, or 0 if the delta is a full state
+ * - the next entity ID of the world
+ * - the number of records N, then N records of:
+ *   - the entity ID
+ *   - the mask of the replicated components the entity now has, with 0
+ *     meaning that it was deleted
+ *   - the mask of the components whose values follow, in bit order:
+ *     - Position, Velocity: x and y in units of 1/`POSITION_QUANTA`,
+ *       minus the baseline value (0 for new components)
+ *     - Circle, Rectangle, Style: their fields
+ *     - Link: the target entity and the relative position as above
+ *     - TileMap: either `TILE_MAP_FULL` and the whole map, or
+ *       `TILE_MAP_CELLS`, the number of changed cells as a uint32 and for
+ *       each one its index (minus the previous one), style and hit points
+ *
+ * Records hold absolute values, so a viewer applies a delta to its own copy
+ * of the baseline rather than to whatever it received last.
+ */
+namespace StateDelta {
+    constexpr float POSITION_QUANTA = 64;
+
+    /**
+     * First message of a stream, before any delta, with what a viewer needs
+     * to open its window: "ARKS", the version of the format and the board
+     * size as floats.
+     */
+    struct StreamHeader {
+        float boardWidth;
+        float boardHeight;
+    };
+
+    constexpr char STREAM_MAGIC[4] = { 'A', 'R', 'K', 'S' };
+    constexpr std::uint32_t STREAM_VERSION = 1;
+
+    std::vector<std::uint8_t> encodeStreamHeader(const StreamHeader&);
+
+    /**
+     * Throws `std::runtime_error` if the message isn't a header of this
+     * version.
+     */
+    StreamHeader decodeStreamHeader(const std::uint8_t* data, std::size_t size);
+
+    enum TileMapEncoding : std::uint8_t {
+        TILE_MAP_FULL = 0,
+        TILE_MAP_CELLS = 1,
+    };
+
+    namespace __detail {
+        template<typename T>
+        constexpr bool isReplicatedTag = std::is_empty_v<T> || std::is_same_v<T, StaticLayer>;
+
+        inline std::int64_t quantize(float value) {
+            return std::llround(value * StateDelta::POSITION_QUANTA);
+        }
+
+        inline void appendVarint(std::vector<std::uint8_t>& output, std::uint64_t value) {
+            while (value >= 0x80) {
+                output.push_back(static_cast<std::uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+
+            output.push_back(static_cast<std::uint8_t>(value));
+        }
+
+        inline void appendSigned(std::vector<std::uint8_t>& output, std::int64_t value) {
+            appendVarint(output, (static_cast<std::uint64_t>(value) << 1) ^ (value >> 63));
+        }
+
+        inline void appendUint32(std::vector<std::uint8_t>& output, std::uint32_t value) {
+            for (std::size_t i = 0; i < 4; i++) {
+                output.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+            }
+        }
+
+        inline void appendFloat(std::vector<std::uint8_t>& output, float value) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            appendUint32(output, bits);
+        }
+
+        inline void appendStyle(std::vector<std::uint8_t>& output, const Style& style) {
+            appendUint32(output, style.fillColor.toInteger());
+            appendUint32(output, style.borderColor.toInteger());
+            appendFloat(output, style.borderThickness);
+        }
+
+        /**
+         * Bounds-checked reading of an encoded delta.
+         */
+        class DeltaReader {
+         public:
+            DeltaReader(const std::uint8_t* data, std::size_t size) : data(data), size(size) { }
+
+            bool atEnd() const {
+                return position == size;
+            }
+
+            std::size_t remaining() const {
+                return size - position;
+            }
+
+            std::uint8_t byte() {
+                if (position == size) {
+                    throw std::runtime_error("truncated state delta");
+                }
+
+                return data[position++];
+            }
+
+            std::uint64_t varint() {
+                std::uint64_t result = 0;
+
+                for (unsigned shift = 0; shift < 64; shift += 7) {
+                    std::uint8_t next = byte();
+                    result |= std::uint64_t(next & 0x7F) << shift;
+
+                    if (!(next & 0x80)) {
+                        return result;
+                    }
+                }
+
+                throw std::runtime_error("malformed state delta");
+            }
+
+            std::int64_t signedVarint() {
+                std::uint64_t value = varint();
+                return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+            }
+
+            std::uint32_t uint32() {
+                std::uint32_t result = 0;
+
+                for (std::size_t i = 0; i < 4; i++) {
+                    result |= std::uint32_t(byte()) << (8 * i);
+                }
+
+                return result;
+            }
+
+            float float32() {
+                std::uint32_t bits = uint32();
+                float value;
+                std::memcpy(&value, &bits, sizeof(value));
+                return value;
+            }
+
+            Style style() {
+                Style result;
+                result.fillColor = sf::Color(uint32());
+                result.borderColor = sf::Color(uint32());
+                result.borderThickness = float32();
+                return result;
+            }
+
+         private:
+            const std::uint8_t* data;
+            std::size_t size;
+            std::size_t position = 0;
+        };
+
+        template<typename T>
+        inline bool samePoint(const T& lhs, const T& rhs) {
+            return quantize(lhs.x) == quantize(rhs.x) && quantize(lhs.y) == quantize(rhs.y);
+        }
+
+        inline bool sameStyle(const Style& lhs, const Style& rhs) {
+            return lhs.fillColor == rhs.fillColor
+                && lhs.borderColor == rhs.borderColor
+                && lhs.borderThickness == rhs.borderThickness;
+        }
+
+        inline bool sameTileMapLayout(const TileMap& lhs, const TileMap& rhs) {
+            return lhs.origin.x == rhs.origin.x
+                && lhs.origin.y == rhs.origin.y
+                && lhs.cellWidth == rhs.cellWidth
+                && lhs.cellHeight == rhs.cellHeight
+                && lhs.columns == rhs.columns
+                && lhs.rows == rhs.rows
+                && std::equal(
+                    lhs.palette.begin(), lhs.palette.end(),
+                    rhs.palette.begin(), rhs.palette.end(),
+                    sameStyle
+                );
+        }
+
+        inline bool sameCells(const TileCell& lhs, const TileCell& rhs) {
+            return lhs.style == rhs.style && lhs.hitPoints == rhs.hitPoints;
+        }
+
+        /**
+         * Checks if the replicated value of a component changed. Tile maps are
+         * compared cell by cell rather than by row revisions, which restart
+         * when the level is replaced.
+         */
+        template<typename T>
+        inline bool sameReplicatedValue(const T& lhs, const T& rhs) {
+            if constexpr (std::is_same_v<T, Position> || std::is_same_v<T, Velocity>) {
+                return samePoint(lhs, rhs);
+            } else if constexpr (std::is_same_v<T, Circle>) {
+                return lhs.radius == rhs.radius;
+            } else if constexpr (std::is_same_v<T, Rectangle>) {
+                return lhs.width == rhs.width && lhs.height == rhs.height;
+            } else if constexpr (std::is_same_v<T, Style>) {
+                return sameStyle(lhs, rhs);
+            } else if constexpr (std::is_same_v<T, Link>) {
+                return lhs.target == rhs.target && samePoint(lhs.relativePosition, rhs.relativePosition);
+            } else {
+                static_assert(std::is_same_v<T, TileMap>);
+                return sameTileMapLayout(lhs, rhs)
+                    && std::equal(lhs.cells.begin(), lhs.cells.end(), rhs.cells.begin(), sameCells);
+            }
+        }
+
+        template<typename T>
+        inline void appendPoint(std::vector<std::uint8_t>& output, const T* before, const T& after) {
+            appendSigned(output, quantize(after.x) - (before ? quantize(before->x) : 0));
+            appendSigned(output, quantize(after.y) - (before ? quantize(before->y) : 0));
+        }
+
+        template<typename T>
+        inline T readPoint(DeltaReader& reader, const T* before) {
+            std::int64_t x = reader.signedVarint() + (before ? quantize(before->x) : 0);
+            std::int64_t y = reader.signedVarint() + (before ? quantize(before->y) : 0);
+
+            T result;
+            result.x = x / StateDelta::POSITION_QUANTA;
+            result.y = y / StateDelta::POSITION_QUANTA;
+            return result;
+        }
+
+        inline void appendTileMap(
+            std::vector<std::uint8_t>& output,
+            const TileMap* before,
+            const TileMap& after
+        ) {
+            if (before && sameTileMapLayout(*before, after)) {
+                output.push_back(StateDelta::TILE_MAP_CELLS);
+
+                std::size_t countPosition = output.size();
+                std::uint32_t changedCells = 0;
+                std::size_t previousIndex = 0;
+                appendUint32(output, 0);
+
+                for (unsigned row = 0; row < after.rows; row++) {
+                    std::size_t first = std::size_t(row) * after.columns;
+                    std::size_t last = first + after.columns;
+
+                    if (std::equal(after.cells.begin() + first, after.cells.begin() + last, before->cells.begin() + first, sameCells)) {
+                        continue;
+                    }
+
+                    for (std::size_t i = first; i < last; i++) {
+                        if (!sameCells(before->cells[i], after.cells[i])) {
+                            appendVarint(output, i - previousIndex);
+                            output.push_back(after.cells[i].style);
+                            output.push_back(after.cells[i].hitPoints);
+                            previousIndex = i;
+                            changedCells++;
+                        }
+                    }
+                }
+
+                // The count is only known once the rows are scanned
+                for (std::size_t i = 0; i < 4; i++) {
+                    output[countPosition + i] = static_cast<std::uint8_t>(changedCells >> (8 * i));
+                }
+
+                return;
+            }
+
+            output.push_back(StateDelta::TILE_MAP_FULL);
+            appendFloat(output, after.origin.x);
+            appendFloat(output, after.origin.y);
+            appendFloat(output, after.cellWidth);
+            appendFloat(output, after.cellHeight);
+            appendVarint(output, after.columns);
+            appendVarint(output, after.rows);
+            appendVarint(output, after.palette.size());
+
+            for (const Style& style : after.palette) {
+                appendStyle(output, style);
+            }
+
+            for (const TileCell& cell : after.cells) {
+                output.push_back(cell.style);
+                output.push_back(cell.hitPoints);
+            }
+        }
+
+        template<typename T>
+        inline void appendValue(std::vector<std::uint8_t>& output, const T* before, const T& after) {
+            if constexpr (std::is_same_v<T, Position> || std::is_same_v<T, Velocity>) {
+                appendPoint(output, before, after);
+            } else if constexpr (std::is_same_v<T, Circle>) {
+                appendFloat(output, after.radius);
+            } else if constexpr (std::is_same_v<T, Rectangle>) {
+                appendFloat(output, after.width);
+                appendFloat(output, after.height);
+            } else if constexpr (std::is_same_v<T, Style>) {
+                appendStyle(output, after);
+            } else if constexpr (std::is_same_v<T, Link>) {
+                appendVarint(output, after.target);
+                appendPoint(output, before ? &before->relativePosition : nullptr, after.relativePosition);
+            } else {
+                static_assert(std::is_same_v<T, TileMap>);
+                appendTileMap(output, before, after);
+            }
+        }
+
+        template<typename Tuple>
+        struct ChunkSlotsOf;
+
+        /**
+         * The replicated components of one chunk of entities in a snapshot,
+         * indexed by entity ID within the chunk.
+         */
+        template<typename... Ts>
+        struct ChunkSlotsOf<std::tuple<Ts...>> {
+            using Type = std::tuple<std::array<const Ts*, ecs::SNAPSHOT_CHUNK_SIZE>...>;
+        };
+
+        using ChunkSlots = ChunkSlotsOf<ReplicatedComponents>::Type;
+
+        /**
+         * Fills the slots of a chunk from a snapshot. A null snapshot stands
+         * for an empty world.
+         */
+        inline void fillChunkSlots(
+            ChunkSlots& slots,
+            const ecs::World::Snapshot* snapshot,
+            std::size_t chunk
+        ) {
+            meta::forEachT<ReplicatedComponents>([&]<typename T>() {
+                auto& typeSlots = std::get<std::array<const T*, ecs::SNAPSHOT_CHUNK_SIZE>>(slots);
+                typeSlots.fill(nullptr);
+
+                if (!snapshot) {
+                    return;
+                }
+
+                if (const ecs::SnapshotChunk<T>* data = ecs::chunkAt(ecs::tableOf<T>(*snapshot), chunk)) {
+                    for (const auto& [entity, value] : *data) {
+                        typeSlots[entity % ecs::SNAPSHOT_CHUNK_SIZE] = &value;
+                    }
+                }
+            });
+        }
+
+        template<typename T>
+        inline const T* slotOf(const ChunkSlots& slots, ecs::Entity entity) {
+            return std::get<std::array<const T*, ecs::SNAPSHOT_CHUNK_SIZE>>(slots)[entity % ecs::SNAPSHOT_CHUNK_SIZE];
+        }
+
+        /**
+         * Calls `fn(chunk)`, in order, for every chunk whose replicated
+         * components are not shared between two snapshots of a world, which
+         * is where the entities that changed between them are. Null snapshots
+         * stand for an empty world.
+         */
+        template<typename F>
+        inline void forEachChangedChunk(
+            const ecs::World::Snapshot* before,
+            const ecs::World::Snapshot* after,
+            F fn
+        ) {
+            std::size_t pageCount = 0;
+
+            meta::forEachT<ReplicatedComponents>([&]<typename T>() {
+                pageCount = std::max({
+                    pageCount,
+                    before ? ecs::tableOf<T>(*before).size() : 0,
+                    after ? ecs::tableOf<T>(*after).size() : 0
+                });
+            });
+
+            auto pageOf = []<typename T>(const ecs::World::Snapshot* snapshot, std::size_t page) {
+                return snapshot ? ecs::pageAt(ecs::tableOf<T>(*snapshot), page) : nullptr;
+            };
+
+            auto chunkOf = []<typename T>(const ecs::World::Snapshot* snapshot, std::size_t chunk) {
+                return snapshot ? ecs::chunkAt(ecs::tableOf<T>(*snapshot), chunk) : nullptr;
+            };
+
+            for (std::size_t page = 0; page < pageCount; page++) {
+                bool samePages = true;
+
+                meta::forEachT<ReplicatedComponents>([&]<typename T>() {
+                    samePages &= pageOf.template operator()<T>(before, page) == pageOf.template operator()<T>(after, page);
+                });
+
+                if (samePages) {
+                    continue;
+                }
+
+                for (std::size_t i = 0; i < ecs::SNAPSHOT_PAGE_SIZE; i++) {
+                    std::size_t chunk = page * ecs::SNAPSHOT_PAGE_SIZE + i;
+                    bool sameChunks = true;
+
+                    meta::forEachT<ReplicatedComponents>([&]<typename T>() {
+                        sameChunks &= chunkOf.template operator()<T>(before, chunk) == chunkOf.template operator()<T>(after, chunk);
+                    });
+
+                    if (!sameChunks) {
+                        fn(chunk);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Makes the cells of a tile map match another one with the same
+         * layout, giving the rows that change the revision `revision`.
+         */
+        inline void syncCells(TileMap& target, const TileMap& source, unsigned revision) {
+            for (unsigned row = 0; row < target.rows; row++) {
+                auto first = std::size_t(row) * target.columns;
+                auto last = first + target.columns;
+
+                if (!std::equal(source.cells.begin() + first, source.cells.begin() + last, target.cells.begin() + first, sameCells)) {
+                    std::copy(source.cells.begin() + first, source.cells.begin() + last, target.cells.begin() + first);
+                    target.rowRevisions[row] = revision;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Encodes the snapshots of a world as deltas against the last snapshot
+ * that the viewer acknowledged. The world must save a snapshot every tick
+ * that is sent, and keep enough of them to cover the acknowledgement
+ * delay; when the baseline is no longer available, a full state is sent.
+ */
+class DeltaEncoder {
+ public:
+    /**
+     * Appends the delta from the acknowledged baseline to the snapshot
+     * `current` of `world`.
+     */
+    void encode(const ecs::World& world, ecs::SnapshotId current, std::vector<std::uint8_t>& output);
+
+    /**
+     * Records that the viewer received the delta that brought it to the
+     * snapshot `id`, so that it can be used as the next baseline.
+     */
+    void acknowledge(ecs::SnapshotId id);
+
+ private:
+    std::optional<ecs::SnapshotId> baseline;
+    StateDelta::__detail::ChunkSlots before;
+    StateDelta::__detail::ChunkSlots after;
+    std::vector<std::uint8_t> records;
+    std::size_t recordCount = 0;
+
+    void encodeChunk(std::size_t chunk, std::size_t entityBound);
+};
+
+inline void DeltaEncoder::encode(
+    const ecs::World& world,
+    ecs::SnapshotId current,
+    std::vector<std::uint8_t>& output
+) {
+    PROFILE_SCOPE("DeltaEncoder::encode");
+
+    if (baseline && !world.hasSnapshot(*baseline)) {
+        baseline.reset();
+    }
+
+    const ecs::World::Snapshot& currentSnapshot = world.getSnapshot(current);
+    const ecs::World::Snapshot* baselineSnapshot = baseline ? &world.getSnapshot(*baseline) : nullptr;
+    std::size_t entityBound = std::max(
+        currentSnapshot.nextEntityId,
+        baselineSnapshot ? baselineSnapshot->nextEntityId : 0
+    );
+
+    records.clear();
+    recordCount = 0;
+
+    StateDelta::__detail::forEachChangedChunk(baselineSnapshot, &currentSnapshot, [&](std::size_t chunk) {
+        StateDelta::__detail::fillChunkSlots(before, baselineSnapshot, chunk);
+        StateDelta::__detail::fillChunkSlots(after, &currentSnapshot, chunk);
+        encodeChunk(chunk, entityBound);
+    });
+
+    StateDelta::__detail::appendVarint(output, current);
+    StateDelta::__detail::appendVarint(output, baseline ? *baseline + 1 : 0);
+    StateDelta::__detail::appendVarint(output, currentSnapshot.nextEntityId);
+    StateDelta::__detail::appendVarint(output, recordCount);
+    output.insert(output.end(), records.begin(), records.end());
+}
+
+inline void DeltaEncoder::acknowledge(ecs::SnapshotId id) {
+    if (!baseline || id > *baseline) {
+        baseline = id;
+    }
+}
+
+/**
+ * Appends a record for every entity of a chunk whose replicated components
+ * changed. The slots of the chunk must have been filled.
+ */
+inline void DeltaEncoder::encodeChunk(std::size_t chunk, std::size_t entityBound) {
+    ecs::Entity first = chunk * ecs::SNAPSHOT_CHUNK_SIZE;
+    ecs::Entity last = std::min<std::size_t>(first + ecs::SNAPSHOT_CHUNK_SIZE, entityBound);
+
+    for (ecs::Entity entity = first; entity < last; entity++) {
+        std::uint32_t beforeMask = 0;
+        std::uint32_t afterMask = 0;
+        std::uint32_t changedMask = 0;
+        unsigned bit = 0;
+
+        meta::forEachT<ReplicatedComponents>([&]<typename T>() {
+            const T* beforeData = StateDelta::__detail::slotOf<T>(before, entity);
+            const T* afterData = StateDelta::__detail::slotOf<T>(after, entity);
+
+            beforeMask |= beforeData ? (1u << bit) : 0;
+            afterMask |= afterData ? (1u << bit) : 0;
+
+            // Components in chunks shared by both snapshots are the same object
+            if constexpr (!StateDelta::__detail::isReplicatedTag<T>) {
+                if (afterData && afterData != beforeData
+                    && (!beforeData || !StateDelta::__detail::sameReplicatedValue(*beforeData, *afterData))) {
+                    changedMask |= 1u << bit;
+                }
+            }
+
+            bit++;
+        });
+
+        if (beforeMask == afterMask && changedMask == 0) {
+            continue;
+        }
+
+        StateDelta::__detail::appendVarint(records, entity);
+        StateDelta::__detail::appendVarint(records, afterMask);
+        StateDelta::__detail::appendVarint(records, changedMask);
+        recordCount++;
+        bit = 0;
+
+        meta::forEachT<ReplicatedComponents>([&]<typename T>() {
+            if constexpr (!StateDelta::__detail::isReplicatedTag<T>) {
+                if (changedMask & (1u << bit)) {
+                    StateDelta::__detail::appendValue(
+                        records,
+                        StateDelta::__detail::slotOf<T>(before, entity),
+                        *StateDelta::__detail::slotOf<T>(after, entity)
+                    );
+                }
+            }
+
+            bit++;
+        });
+    }
+}
+
+/**
+ * Applies the deltas of a `DeltaEncoder` to a viewer world, which must be
+ * empty at first and must not be changed otherwise (apart from rendering).
+ * Every applied delta is saved as a snapshot of the viewer world, which
+ * is how the baselines of later deltas are found.
+ *
+ * A delta is applied to the latest state rather than to a restored copy
+ * of its baseline: the entities it lists are brought to their new state,
+ * and those that only changed since the baseline are reverted to it.
+ * Components are only written when their value changes, so the viewer
+ * snapshots keep sharing everything that didn't change.
+ */
+class DeltaDecoder {
+ public:
+    /**
+     * Applies a delta to `world` and returns the server snapshot ID to
+     * acknowledge. Throws `std::runtime_error` if the delta is malformed or
+     * its baseline is no longer available.
+     */
+    ecs::SnapshotId apply(ecs::World& world, const std::uint8_t* data, std::size_t size);
+
+ private:
+    // Server snapshot IDs and the matching viewer snapshot IDs, oldest first
+    std::deque<std::pair<ecs::SnapshotId, ecs::SnapshotId>> snapshots;
+    std::vector<ecs::Entity> listedEntities;
+    StateDelta::__detail::ChunkSlots baselineSlots;
+    StateDelta::__detail::ChunkSlots latestSlots;
+    unsigned nextRowRevision = 0;
+
+    const ecs::World::Snapshot& findBaseline(const ecs::World&, ecs::SnapshotId baseline) const;
+
+    void applyRecord(
+        ecs::World&,
+        ecs::Entity,
+        std::uint32_t mask,
+        std::uint32_t changed,
+        StateDelta::__detail::DeltaReader&
+    );
+
+    void revertEntity(ecs::World&, ecs::Entity);
+
+    template<typename T>
+    void revertComponent(ecs::World&, ecs::Entity, const T* baselineData, const T* latestData);
+
+    void readTileMap(
+        ecs::World&,
+        ecs::Entity,
+        const TileMap* baselineData,
+        const TileMap* latestData,
+        StateDelta::__detail::DeltaReader&
+    );
+};
+
+inline ecs::SnapshotId DeltaDecoder::apply(
+    ecs::World& world,
+    const std::uint8_t* data,
+    std::size_t size
+) {
+    PROFILE_SCOPE("DeltaDecoder::apply");
+
+    StateDelta::__detail::DeltaReader reader(data, size);
+    ecs::SnapshotId current = reader.varint();
+    std::uint64_t baseline = reader.varint();
+    std::uint64_t entityBound = reader.varint();
+    // Full states are encoded against an empty world
+    const ecs::World::Snapshot* baselineSnapshot = (baseline > 0) ? &findBaseline(world, baseline - 1) : nullptr;
+    const ecs::World::Snapshot* latestSnapshot = snapshots.empty() ? nullptr : &world.getSnapshot(snapshots.back().second);
+
+    // Entity IDs are the server ones, so the viewer has to allocate them
+    ecs::Entity nextEntity = world.createEntities(0);
+    if (entityBound > nextEntity) {
+        world.createEntities(entityBound - nextEntity);
+    }
+
+    std::size_t slotsChunk = SIZE_MAX;
+    auto useChunk = [&](std::size_t chunk) {
+        if (chunk != slotsChunk) {
+            StateDelta::__detail::fillChunkSlots(baselineSlots, baselineSnapshot, chunk);
+            StateDelta::__detail::fillChunkSlots(latestSlots, latestSnapshot, chunk);
+            slotsChunk = chunk;
+        }
+    };
+
+    std::uint64_t recordCount = reader.varint();
+    listedEntities.clear();
+
+    for (std::uint64_t i = 0; i < recordCount; i++) {
+        std::uint64_t entity = reader.varint();
+        std::uint32_t mask = reader.varint();
+        std::uint32_t changed = reader.varint();
+
+        // Deleted entities may be past the end if the server world shrank
+        if ((!listedEntities.empty() && entity <= listedEntities.back())
+            || entity >= std::max<std::uint64_t>(entityBound, world.createEntities(0))
+            || (mask >> std::tuple_size_v<ReplicatedComponents>)
+            || (changed & ~mask)) {
+            throw std::runtime_error("malformed state delta");
+        }
+
+        useChunk(entity / ecs::SNAPSHOT_CHUNK_SIZE);
+        listedEntities.push_back(entity);
+
+        applyRecord(world, entity, mask, changed, reader);
+    }
+
+    if (!reader.atEnd()) {
+        throw std::runtime_error("malformed state delta");
+    }
+
+    auto listed = listedEntities.begin();
+
+    StateDelta::__detail::forEachChangedChunk(baselineSnapshot, latestSnapshot, [&](std::size_t chunk) {
+        useChunk(chunk);
+        ecs::Entity first = chunk * ecs::SNAPSHOT_CHUNK_SIZE;
+
+        for (ecs::Entity entity = first; entity < first + ecs::SNAPSHOT_CHUNK_SIZE; entity++) {
+            while (listed != listedEntities.end() && *listed < entity) {
+                ++listed;
+            }
+
+            if (listed != listedEntities.end() && *listed == entity) {
+                continue;
+            }
+
+            revertEntity(world, entity);
+        }
+    });
+
+    snapshots.emplace_back(current, world.saveSnapshot());
+
+    while (!world.hasSnapshot(snapshots.front().second)) {
+        snapshots.pop_front();
+    }
+
+    return current;
+}
+
+inline const ecs::World::Snapshot& DeltaDecoder::findBaseline(
+    const ecs::World& world,
+    ecs::SnapshotId baseline
+) const {
+    auto it = std::find_if(snapshots.begin(), snapshots.end(), [baseline](const auto& ids) {
+        return ids.first == baseline;
+    });
+
+    if (it == snapshots.end() || !world.hasSnapshot(it->second)) {
+        throw std::runtime_error("state delta baseline no longer available");
+    }
+
+    return world.getSnapshot(it->second);
+}
+
+/**
+ * Brings an entity to the state given by its record. The components that
+ * the record has no value for are the baseline ones.
+ */
+inline void DeltaDecoder::applyRecord(
+    ecs::World& world,
+    ecs::Entity entity,
+    std::uint32_t mask,
+    std::uint32_t changed,
+    StateDelta::__detail::DeltaReader& reader
+) {
+    const ecs::World& constWorld = world;
+    unsigned bit = 0;
+
+    meta::forEachT<ReplicatedComponents>([&]<typename T>() {
+        std::uint32_t flag = 1u << bit++;
+        const T* baselineData = StateDelta::__detail::slotOf<T>(baselineSlots, entity);
+        const T* latestData = StateDelta::__detail::slotOf<T>(latestSlots, entity);
+
+        if (!(mask & flag) || !(changed & flag)) {
+            if constexpr (StateDelta::__detail::isReplicatedTag<T>) {
+                if ((mask & flag) && !world.hasComponent<T>(entity)) {
+                    world.addComponent(entity, T { });
+                } else if (!(mask & flag) && world.hasComponent<T>(entity)) {
+                    world.removeComponent<T>(entity);
+                }
+            } else {
+                if ((mask & flag) && !baselineData) {
+                    throw std::runtime_error("state delta doesn't match its baseline");
+                }
+
+                revertComponent(world, entity, (mask & flag) ? baselineData : nullptr, latestData);
+            }
+
+            return;
+        }
+
+        if constexpr (!StateDelta::__detail::isReplicatedTag<T>) {
+            const T* existing = world.hasComponent<T>(entity) ? &constWorld.getData<T>(entity) : nullptr;
+
+            auto update = [&](T&& value) {
+                if (!existing || !StateDelta::__detail::sameReplicatedValue(*existing, value)) {
+                    world.replaceComponent(entity, std::move(value));
+                }
+            };
+
+            if constexpr (std::is_same_v<T, Position> || std::is_same_v<T, Velocity>) {
+                update(StateDelta::__detail::readPoint(reader, baselineData));
+            } else if constexpr (std::is_same_v<T, Circle>) {
+                update(Circle { reader.float32() });
+            } else if constexpr (std::is_same_v<T, Rectangle>) {
+                float width = reader.float32();
+                update(Rectangle { width, reader.float32() });
+            } else if constexpr (std::is_same_v<T, Style>) {
+                update(reader.style());
+            } else if constexpr (std::is_same_v<T, Link>) {
+                ecs::Entity target = reader.varint();
+                const Position* relativePosition = baselineData ? &baselineData->relativePosition : nullptr;
+                update(Link { target, StateDelta::__detail::readPoint(reader, relativePosition) });
+            } else {
+                static_assert(std::is_same_v<T, TileMap>);
+                readTileMap(world, entity, baselineData, latestData, reader);
+            }
+        }
+    });
+
+}
+
+/**
+ * Brings an entity that is not in a delta back to its baseline state,
+ * since it didn't change between the baseline and the new state.
+ */
+inline void DeltaDecoder::revertEntity(ecs::World& world, ecs::Entity entity) {
+
+    meta::forEachT<ReplicatedComponents>([&]<typename T>() {
+        const T* baselineData = StateDelta::__detail::slotOf<T>(baselineSlots, entity);
+        const T* latestData = StateDelta::__detail::slotOf<T>(latestSlots, entity);
+
+        if constexpr (StateDelta::__detail::isReplicatedTag<T>) {
+            if (baselineData && !world.hasComponent<T>(entity)) {
+                world.addComponent(entity, T { });
+            } else if (!baselineData && world.hasComponent<T>(entity)) {
+                world.removeComponent<T>(entity);
+            }
+        } else {
+            revertComponent(world, entity, baselineData, latestData);
+        }
+    });
+
+}
+
+/**
+ * Gives an entity the baseline value of a component, or removes it if the
+ * baseline didn't have it. `latestData` is the value in the latest viewer
+ * snapshot, which the world still has: if both come from a shared chunk,
+ * there is nothing to compare.
+ */
+template<typename T>
+inline void DeltaDecoder::revertComponent(
+    ecs::World& world,
+    ecs::Entity entity,
+    const T* baselineData,
+    const T* latestData
+) {
+    if (baselineData == latestData) {
+        return;
+    }
+
+    bool present = world.hasComponent<T>(entity);
+
+    if (!baselineData) {
+        if (present) {
+            world.removeComponent<T>(entity);
+        }
+
+        return;
+    }
+
+    const ecs::World& constWorld = world;
+    if (present && StateDelta::__detail::sameReplicatedValue(constWorld.getData<T>(entity), *baselineData)) {
+        return;
+    }
+
+    if constexpr (std::is_same_v<T, TileMap>) {
+        if (present && StateDelta::__detail::sameTileMapLayout(constWorld.getData<TileMap>(entity), *baselineData)) {
+            StateDelta::__detail::syncCells(world.getData<TileMap>(entity), *baselineData, ++nextRowRevision);
+            return;
+        }
+
+        TileMap tileMap = *baselineData;
+        tileMap.rowRevisions.assign(tileMap.rows, ++nextRowRevision);
+        world.replaceComponent(entity, std::move(tileMap));
+    } else {
+        world.replaceComponent(entity, T(*baselineData));
+    }
+}
+
+/**
+ * Reads a tile map. If only cells changed, the existing map is updated in
+ * place: first back to the baseline cells, then with the changed ones.
+ * Changed rows get revisions that were never used by this decoder, so
+ * that render caches built from other states of the map are not mistaken
+ * for current ones.
+ */
+inline void DeltaDecoder::readTileMap(
+    ecs::World& world,
+    ecs::Entity entity,
+    const TileMap* baselineData,
+    const TileMap* latestData,
+    StateDelta::__detail::DeltaReader& reader
+) {
+    if (reader.byte() == StateDelta::TILE_MAP_CELLS) {
+        if (!baselineData) {
+            throw std::runtime_error("state delta doesn't match its baseline");
+        }
+
+        revertComponent(world, entity, baselineData, latestData);
+        std::uint32_t changedCells = reader.uint32();
+
+        if (changedCells == 0) {
+            return;
+        }
+
+        TileMap& tileMap = world.getData<TileMap>(entity);
+        std::size_t index = 0;
+        unsigned revision = ++nextRowRevision;
+
+        for (std::uint32_t i = 0; i < changedCells; i++) {
+            index += reader.varint();
+
+            if (index >= tileMap.cells.size()) {
+                throw std::runtime_error("malformed state delta");
+            }
+
+            tileMap.cells[index].style = reader.byte();
+            tileMap.cells[index].hitPoints = reader.byte();
+            tileMap.rowRevisions[index / tileMap.columns] = revision;
+        }
+
+        return;
+    }
+
+    float originX = reader.float32();
+    float originY = reader.float32();
+    float cellWidth = reader.float32();
+    float cellHeight = reader.float32();
+    unsigned columns = reader.varint();
+    unsigned rows = reader.varint();
+
+    std::vector<Style> palette(reader.varint());
+    for (Style& style : palette) {
+        style = reader.style();
+    }
+
+    // Each cell takes 2 bytes, which bounds what a malformed size allocates
+    if (std::uint64_t(columns) * rows > reader.remaining() / 2) {
+        throw std::runtime_error("truncated state delta");
+    }
+
+    std::vector<TileCell> cells(std::size_t(columns) * rows);
+    for (TileCell& cell : cells) {
+        cell.style = reader.byte();
+        cell.hitPoints = reader.byte();
+    }
+
+    TileMap tileMap {
+        Position { originX, originY },
+        cellWidth,
+        cellHeight,
+        columns,
+        rows,
+        std::move(palette),
+        std::move(cells)
+    };
+
+    // Same as reverting, with the decoded map as the target
+    revertComponent(world, entity, &tileMap, latestData);
+}
+
+inline std::vector<std::uint8_t> StateDelta::encodeStreamHeader(const StreamHeader& header) {
+    std::vector<std::uint8_t> output(std::begin(STREAM_MAGIC), std::end(STREAM_MAGIC));
+    __detail::appendUint32(output, STREAM_VERSION);
+    __detail::appendFloat(output, header.boardWidth);
+    __detail::appendFloat(output, header.boardHeight);
+    return output;
+}
+
+inline StateDelta::StreamHeader StateDelta::decodeStreamHeader(const std::uint8_t* data, std::size_t size) {
+    __detail::DeltaReader reader(data, size);
+
+    for (char expected : STREAM_MAGIC) {
+        if (reader.byte() != static_cast<std::uint8_t>(expected)) {
+            throw std::runtime_error("not a state stream");
+        }
+    }
+
+    if (reader.uint32() != STREAM_VERSION) {
+        throw std::runtime_error("unsupported state stream version");
+    }
+
+    StreamHeader header;
+    header.boardWidth = reader.float32();
+    header.boardHeight = reader.float32();
+    return header;
+}
@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "../engine-glue/ecs.hpp"
+#include "../engine/simd/integrate.hpp"
+#include "../LevelFile.hpp"
+#include "../systems/level-loading-system/include.hpp"
+#include "../systems/movement-system/include.hpp"
+
+/**
+ * Microbenchmarks of the ECS core, using the same storage as the game,
+ * and of building generated levels.
+ *
+ * Every case runs at 10^3 to 10^6 entities and reports the best of a few
+ * repetitions, in nanoseconds per entity, as JSON. The JSON goes to the
+ * file given as the first argument, or to stdout.
+ *
+ * Usage: `ecs-benchmark [output.json] [max-entities]`
+ */
+struct BenchmarkResult {
+    std::string name;
+    std::size_t entities;
+    unsigned repetitions;
+    double bestNanoseconds;
+    double nanosecondsPerEntity;
+};
+
+/**
+ * A benchmark case: `setup` prepares a fresh world (untimed), then `run`
+ * is timed. Both receive the entity count.
+ */
+struct BenchmarkCase {
+    std::string name;
+    std::function<void(ecs::World&, std::size_t)> setup;
+    std::function<void(ecs::World&, std::size_t)> run;
+    // Optional, called after every repetition outside of the timing
+    std::function<void()> teardown;
+};
+
+static std::vector<BenchmarkCase> createCases();
+static BenchmarkResult measure(const BenchmarkCase&, std::size_t entities);
+static void populate(ecs::World&, std::size_t entities);
+static void moveFirstEntities(ecs::World&);
+static BenchmarkCase levelLoadingCase(const std::string& name, BrickLayout);
+static BenchmarkCase levelFileCase(const std::string& name, BrickLayout);
+static BenchmarkCase integrateCase(const std::string& name, simd::InstructionSet);
+static void writeJson(std::ostream&, const std::vector<BenchmarkResult>&);
+
+// Keeps the compiler from optimizing the iterations away
+static volatile float sink;
+
+int main(int argc, char** argv) {
+    std::size_t maxEntities = (argc > 2) ? std::stoul(argv[2]) : 1000000;
+    std::vector<BenchmarkResult> results;
+
+    for (const BenchmarkCase& benchmarkCase : createCases()) {
+        for (std::size_t entities = 1000; entities <= maxEntities; entities *= 10) {
+            results.push_back(measure(benchmarkCase, entities));
+
+            const BenchmarkResult& result = results.back();
+            std::cerr << result.name << " @ " << result.entities << ": "
+                      << result.nanosecondsPerEntity << " ns/entity\n";
+        }
+    }
+
+    if (argc > 1) {
+        std::ofstream file(argv[1]);
+        writeJson(file, results);
+    } else {
+        writeJson(std::cout, results);
+    }
+}
+
+std::vector<BenchmarkCase> createCases() {
+    auto none = [](ecs::World&, std::size_t) { };
+
+    std::vector<BenchmarkCase> cases {
+        {
+            "createEntity",
+            none,
+            [](ecs::World& world, std::size_t entities) {
+                for (std::size_t i = 0; i < entities; i++) {
+                    world.createEntity(Position { 0, 0 }, Velocity { 1, 1 });
+                }
+            }
+        },
+        {
+            "addComponent",
+            populate,
+            [](ecs::World& world, std::size_t entities) {
+                for (ecs::Entity id = 0; id < entities; id++) {
+                    world.addComponent(id, Circle { 1 });
+                }
+            }
+        },
+        {
+            "removeComponent",
+            populate,
+            [](ecs::World& world, std::size_t entities) {
+                for (ecs::Entity id = 0; id < entities; id++) {
+                    world.removeComponent<Velocity>(id);
+                }
+            }
+        },
+        {
+            "deleteEntity",
+            populate,
+            [](ecs::World& world, std::size_t entities) {
+                for (ecs::Entity id = 0; id < entities; id++) {
+                    world.deleteEntity(id);
+                }
+            }
+        },
+        {
+            "clear",
+            populate,
+            [](ecs::World& world, std::size_t) {
+                world.clear();
+            }
+        },
+        {
+            "forEach/1",
+            populate,
+            [](ecs::World& world, std::size_t) {
+                float sum = 0;
+
+                world.findAll<Position>()
+                    .forEach([&sum](const Position& pos) {
+                        sum += pos.x;
+                    });
+
+                sink = sum;
+            }
+        },
+        {
+            "forEach/4",
+            populate,
+            [](ecs::World& world, std::size_t) {
+                float sum = 0;
+
+                world.findAll<Position>()
+                    .join<Velocity>()
+                    .join<Bounds>()
+                    .join<Circle>()
+                    .forEach(
+                        [&sum](
+                            const Position& pos,
+                            const Velocity& v,
+                            const Bounds& bounds,
+                            const Circle& circle
+                        ) {
+                            sum += pos.x + v.x + bounds.minX + circle.radius;
+                        }
+                    );
+
+                sink = sum;
+            }
+        },
+        {
+            "movement/perEntity",
+            populate,
+            [](ecs::World& world, std::size_t) {
+                world.findAll<Position>()
+                    .join<Velocity>()
+                    .forEach([](Position& pos, const Velocity& v) {
+                        pos += v * (1 / 60.0f);
+                    });
+            }
+        },
+        {
+            "useMovementSystem",
+            populate,
+            [](ecs::World& world, std::size_t) {
+                useMovementSystem(world, 1 / 60.0f);
+            }
+        },
+        {
+            "mutatingForEach",
+            populate,
+            [](ecs::World& world, std::size_t) {
+                world.findAll<Velocity>()
+                    .mutatingForEach([&world](ecs::Entity id) {
+                        world.removeComponent<Velocity>(id);
+                    });
+
+                world.frameArena().reset();
+            }
+        },
+        {
+            "notify",
+            [](ecs::World& world, std::size_t entities) {
+                for (std::size_t i = 0; i < entities; i++) {
+                    world.createEntity(GameOverListener { [] { sink = sink + 1; } });
+                }
+            },
+            [](ecs::World& world, std::size_t) {
+                world.notify<GameOverListener>();
+                world.frameArena().reset();
+            }
+        },
+        {
+            "unique",
+            [](ecs::World& world, std::size_t entities) {
+                populate(world, entities);
+                world.createEntity(Paddle { });
+            },
+            [](ecs::World& world, std::size_t entities) {
+                ecs::Entity sum = 0;
+
+                for (std::size_t i = 0; i < entities; i++) {
+                    sum += world.unique<Paddle>();
+                }
+
+                sink = sum;
+            }
+        },
+        {
+            "saveSnapshot",
+            [](ecs::World& world, std::size_t entities) {
+                populate(world, entities);
+                world.saveSnapshot();
+            },
+            [](ecs::World& world, std::size_t) {
+                moveFirstEntities(world);
+                world.saveSnapshot();
+            }
+        },
+        {
+            "restoreSnapshot",
+            [](ecs::World& world, std::size_t entities) {
+                populate(world, entities);
+                world.saveSnapshot();
+                moveFirstEntities(world);
+            },
+            [](ecs::World& world, std::size_t) {
+                world.restoreSnapshot(0);
+            }
+        },
+        levelLoadingCase("useLevelLoadingSystem/grid", BrickLayout::Grid),
+        levelLoadingCase("useLevelLoadingSystem/scatter", BrickLayout::Scatter),
+        levelLoadingCase("useLevelLoadingSystem/clustered", BrickLayout::Clustered),
+        levelFileCase("levelFile/grid", BrickLayout::Grid),
+        levelFileCase("levelFile/scatter", BrickLayout::Scatter),
+    };
+
+    cases.push_back(integrateCase("integrate/scalar", simd::InstructionSet::Scalar));
+
+    if (simd::bestInstructionSet() >= simd::InstructionSet::SSE) {
+        cases.push_back(integrateCase("integrate/sse", simd::InstructionSet::SSE));
+    }
+
+    if (simd::bestInstructionSet() >= simd::InstructionSet::AVX2) {
+        cases.push_back(integrateCase("integrate/avx2", simd::InstructionSet::AVX2));
+    }
+
+    return cases;
+}
+
+/**
+ * Moves a fixed number of entities, i.e the changes of a typical tick,
+ * which is all that snapshots should have to copy.
+ */
+void moveFirstEntities(ecs::World& world) {
+    constexpr ecs::Entity MOVED_ENTITIES = 100;
+
+    for (ecs::Entity id = 0; id < MOVED_ENTITIES; id++) {
+        world.getData<Position>(id).x += 1;
+    }
+}
+
+/**
+ * Runs the movement kernel alone over packed coordinate arrays, one point
+ * per entity, without going through the world.
+ */
+BenchmarkCase integrateCase(const std::string& name, simd::InstructionSet instructionSet) {
+    static std::vector<float> x, y, vx, vy;
+
+    return {
+        name,
+        [](ecs::World&, std::size_t entities) {
+            for (std::vector<float>* values : { &x, &y, &vx, &vy }) {
+                values->assign(entities, 1);
+            }
+        },
+        [instructionSet](ecs::World&, std::size_t entities) {
+            simd::integrate(instructionSet, x.data(), y.data(), vx.data(), vy.data(), entities, 1 / 60.0f);
+            sink = x[entities - 1];
+        }
+    };
+}
+
+/**
+ * Loads a level with one brick per entity of the benchmark.
+ */
+BenchmarkCase levelLoadingCase(const std::string& name, BrickLayout layout) {
+    return {
+        name,
+        [](ecs::World&, std::size_t) { },
+        [layout](ecs::World& world, std::size_t entities) {
+            LevelConfig level;
+            level.brickCount = entities;
+            level.layout = layout;
+
+            useLevelLoadingSystem(world, level);
+        }
+    };
+}
+
+/**
+ * Loads a level file with one brick per entity of the benchmark. The file
+ * is generated and written during the setup, so only ingestion is timed.
+ * It is named after the process, so that concurrent runs don't overwrite
+ * each other's, and removed after each repetition.
+ */
+BenchmarkCase levelFileCase(const std::string& name, BrickLayout layout) {
+    static const std::string path = (
+        std::filesystem::temp_directory_path()
+        / ("ecs-benchmark-" + std::to_string(::getpid()) + ".level")
+    ).string();
+
+    return {
+        name,
+        [layout](ecs::World& world, std::size_t entities) {
+            LevelConfig level;
+            level.brickCount = entities;
+            level.layout = layout;
+
+            useLevelLoadingSystem(world, level);
+
+            std::ofstream file(path, std::ios::binary);
+            saveLevel(file, world);
+            world.clear();
+        },
+        [](ecs::World& world, std::size_t) {
+            LevelConfig level;
+            level.file = path;
+
+            useLevelLoadingSystem(world, level);
+        },
+        [] {
+            std::filesystem::remove(path);
+        }
+    };
+}
+
+BenchmarkResult measure(const BenchmarkCase& benchmarkCase, std::size_t entities) {
+    using Clock = std::chrono::steady_clock;
+    constexpr unsigned MIN_REPETITIONS = 3;
+    constexpr unsigned MAX_REPETITIONS = 50;
+    constexpr double MIN_TOTAL_SECONDS = 0.1;
+
+    double best = 0;
+    double total = 0;
+    unsigned repetitions = 0;
+
+    while (
+        repetitions < MIN_REPETITIONS
+        || (total < MIN_TOTAL_SECONDS && repetitions < MAX_REPETITIONS)
+    ) {
+        // Worlds are large, so they live on the heap
+        auto world = std::make_unique<ecs::World>();
+        benchmarkCase.setup(*world, entities);
+
+        auto start = Clock::now();
+        benchmarkCase.run(*world, entities);
+        auto end = Clock::now();
+
+        if (benchmarkCase.teardown) {
+            benchmarkCase.teardown();
+        }
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        best = (repetitions == 0) ? seconds : std::min(best, seconds);
+        total += seconds;
+        repetitions++;
+    }
+
+    return BenchmarkResult {
+        benchmarkCase.name,
+        entities,
+        repetitions,
+        best * 1e9,
+        best * 1e9 / entities
+    };
+}
+
+/**
+ * Creates entities with the components of moving circles, so that every
+ * query case matches all of them.
+ */
+void populate(ecs::World& world, std::size_t entities) {
+    for (std::size_t i = 0; i < entities; i++) {
+        float x = i;
+
+        world.createEntity(
+            Bounds { x - 1, -1, x + 1, 1 },
+            Circle { 1 },
+            Position { x, 0 },
+            Velocity { 1, 1 }
+        );
+    }
+}
+
+void writeJson(std::ostream& stream, const std::vector<BenchmarkResult>& results) {
+    stream << "{\"benchmarks\":[";
+
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& result = results[i];
+
+        stream << (i > 0 ? ",\n" : "\n")
+               << "{\"name\":\"" << result.name << "\""
+               << ",\"entities\":" << result.entities
+               << ",\"repetitions\":" << result.repetitions
+               << ",\"best_ns\":" << result.bestNanoseconds
+               << ",\"ns_per_entity\":" << result.nanosecondsPerEntity << "}";
+    }
+
+    stream << "\n]}\n";
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * World-space axis-aligned bounding box of an entity. Derived from its
+ * Position and Rectangle/Circle, and refreshed only when those change.
+ */
+struct alignas(16) Bounds {
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+};
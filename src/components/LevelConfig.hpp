@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include "../constants.hpp"
+
+enum class BrickLayout {
+    // Every cell of a tile map is a brick
+    Grid,
+    // Individual brick entities at random positions
+    Scatter,
+    // Round clusters of bricks in a tile map
+    Clustered,
+};
+
+/**
+ * Parameters of the level built by the level loading system. The defaults
+ * describe the classic level, but everything can be scaled up to stress
+ * the engine. Stored in the world, so that the systems that depend on it
+ * (e.g the power-up drop rate) can read it.
+ */
+struct LevelConfig {
+    float boardWidth = constants::WINDOW_WIDTH;
+    float boardHeight = constants::WINDOW_HEIGHT;
+    unsigned brickCount = constants::DEFAULT_BRICK_COUNT;
+    unsigned ballCount = 1;
+    int powerUpDropRate = 50;
+    BrickLayout layout = BrickLayout::Grid;
+    // Level file to load the bricks and walls from instead of generating
+    // them, in which case the other fields are read from it as well
+    std::string file;
+};
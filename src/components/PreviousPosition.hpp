@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../mixins/PointLike.hpp"
+
+/**
+ * Position of the entity at the start of the current tick, used to
+ * interpolate rendering between ticks.
+ */
+struct PreviousPosition : PointLike<PreviousPosition> { };
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "../engine/ecs/ECS.hpp"
+#include "../engine/rendering/CommandList.hpp"
+
+/**
+ * Render commands of a tile map, split in batches of consecutive rows so
+ * that a change to a cell only rebuilds the batch that contains it.
+ * `rowRevisionSums` tracks the row revisions of the tile map each batch
+ * was built from.
+ */
+struct TileMapLayer {
+    std::vector<rendering::StaticBatch> batches;
+    std::vector<unsigned> rowRevisionSums;
+};
+
+/**
+ * Render commands of everything that doesn't move (the entities for which
+ * `staticlayer::isStatic` holds, and tile maps), which the rendering system
+ * only rebuilds where they changed.
+ *
+ * Static entities are split in batches of consecutive IDs, keyed by the
+ * index of their range, which is a chunk of the world. `chunkRevisions`
+ * holds the world's chunk revisions the batches were built from, so that
+ * removing an entity only rebuilds its batch.
+ */
+struct StaticLayer {
+    std::map<ecs::Entity, rendering::StaticBatch> entityBatches;
+    std::vector<std::uint32_t> chunkRevisions;
+    std::unordered_map<ecs::Entity, TileMapLayer> tileMaps;
+};
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <functional>
+#include <memory_resource>
 #include <vector>
 #include "../engine/ecs/ECS.hpp"
 #include "Tags.hpp"
+#include "TileMap.hpp"
 
 namespace metadata {
     struct RectCollisionData {
@@ -12,11 +14,20 @@ namespace metadata {
         bool collidesInY;
     };
 
-    using MultiRectCollisionData = const std::vector<RectCollisionData>&;
+    using MultiRectCollisionData = const std::pmr::vector<RectCollisionData>&;
+
+    struct TileCollisionData {
+        ecs::Entity tileMapId;
+        unsigned cellIndex;
+        bool collidesInX;
+        bool collidesInY;
+    };
+
+    using MultiTileCollisionData = const std::pmr::vector<TileCollisionData>&;
 
     template<typename T, typename U>
     struct CollisionDataWrapper {
-        using Type = const std::vector<ecs::Entity>&;
+        using Type = const std::pmr::vector<ecs::Entity>&;
     };
 
     template<>
@@ -24,6 +35,11 @@ namespace metadata {
         using Type = MultiRectCollisionData;
     };
 
+    template<>
+    struct CollisionDataWrapper<Ball, TileMap> {
+        using Type = MultiTileCollisionData;
+    };
+
     template<>
     struct CollisionDataWrapper<Ball, Wall> {
         using Type = MultiRectCollisionData;
@@ -17,6 +17,13 @@ namespace constants {
 
     constexpr float BOARD_BORDER = 15;
 
+    // A full grid of 6 rows spanning the classic board
+    constexpr unsigned DEFAULT_BRICK_COUNT =
+        static_cast<unsigned>((WINDOW_WIDTH - 2 * BOARD_BORDER) / BRICK_WIDTH) * 6;
+
     constexpr float POWERUP_RADIUS = 10;
     constexpr float POWERUP_VELOCITY = 100;
+
+    constexpr unsigned TICK_RATE = 120;
+    constexpr unsigned MAX_CATCH_UP_TICKS = 8;
 }
@@ -1,39 +1,51 @@
 #pragma once
 
 #include "../components/collision-listeners.hpp"
+#include "../components/Bounds.hpp"
 #include "../components/Circle.hpp"
 #include "../components/GameOverListener.hpp"
+#include "../components/LevelConfig.hpp"
 #include "../components/Link.hpp"
 #include "../components/Position.hpp"
 #include "../components/powerups.hpp"
+#include "../components/PreviousPosition.hpp"
 #include "../components/Rectangle.hpp"
+#include "../components/StaticLayer.hpp"
 #include "../components/Style.hpp"
 #include "../components/Tags.hpp"
-#include "../components/TimedEvent.hpp"
+#include "../components/TileMap.hpp"
 #include "../components/Velocity.hpp"
 #include "../engine/ecs/include.hpp"
+#include "../engine/timing/TimerQueue.hpp"
 
 namespace ecs {
     using ECS = GenericECS<
         Ball,
         BounceCollision,
+        Bounds,
         Brick,
         Circle,
+        timing::Clock,
         CollisionListener<Ball, Brick>,
         CollisionListener<Ball, Paddle>,
+        CollisionListener<Ball, TileMap>,
         CollisionListener<Ball, Wall>,
         CollisionListener<Paddle, PowerUp>,
         CollisionListener<Paddle, Wall>,
         GameOverListener,
         Input,
+        LevelConfig,
         Link,
         Paddle,
         PiercingBall,
         Position,
         PowerUp,
+        PreviousPosition,
         Rectangle,
+        StaticLayer,
         Style,
-        TimedEvent,
+        TileMap,
+        timing::TimerQueue,
         Velocity,
         Visible,
         Wall
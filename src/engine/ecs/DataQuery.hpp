@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <memory_resource>
 #include <tuple>
 #include <type_traits>
 #include "../metaprogramming/lambda-argument-types.hpp"
@@ -11,6 +13,11 @@ namespace ecs {
         struct QueryParameter {
             template<typename ECS>
             static T& get(ECS& storage, Entity entity) {
+                // Only non-const references allow the callback to change data
+                if constexpr (std::is_lvalue_reference_v<T> && !std::is_const_v<std::remove_reference_t<T>>) {
+                    markChanged<std::decay_t<T>>(storage, entity);
+                }
+
                 return entityData<std::decay_t<T>>(storage).at(entity);
             }
         };
@@ -94,19 +101,55 @@ namespace ecs {
         /**
          * Functionally equal to `forEach`, but allows the input function to
          * mutate the components of the iterated entities. This is achieved
-         * through an extra copy, and may have performance implications if
-         * many entities have the first filtered component.
+         * by snapshotting the IDs of the entities with the first filtered
+         * component into the frame arena. Entities that stop matching the
+         * filters during the iteration are skipped.
          */
         template<typename Functor>
         void mutatingForEach(Functor fn) {
-            // Makes a copy due to potential iterator invalidation
-            ComponentData<T> baseData = entityData<T>(storage);
-            internalForEach(fn, baseData);
+            snapshottingForEach(fn, false);
+        }
+
+        /**
+         * Functionally equal to `mutatingForEach`, but visits the entities
+         * in ascending ID order. The order of the other functions depends on
+         * how the storage was built, e.g restoring a snapshot reinserts the
+         * components that differ, so systems whose outcome depends on the
+         * order, e.g because entities interact, use this one to resimulate
+         * the same way.
+         */
+        template<typename Functor>
+        void orderedForEach(Functor fn) {
+            snapshottingForEach(fn, true);
         }
 
     private:
         ECS& storage;
 
+        template<typename Functor>
+        void snapshottingForEach(Functor fn, bool ordered) {
+            // Snapshots the IDs due to potential iterator invalidation
+            ComponentData<T>& baseData = entityData<T>(storage);
+            std::pmr::vector<Entity> entities(&storage.frameArena);
+            entities.reserve(baseData.size());
+
+            for (auto& [entity, data] : baseData) {
+                entities.push_back(entity);
+            }
+
+            if (ordered) {
+                std::sort(entities.begin(), entities.end());
+            }
+
+            __detail::Dispatcher<meta::lambda_argument_types_t<Functor>> dispatcher;
+
+            for (Entity entity : entities) {
+                if (hasAllComponents<T, Ts...>(entity) && hasNoComponents<Us...>(entity)) {
+                    dispatcher(storage, fn, entity);
+                }
+            }
+        }
+
         template<typename U>
         bool hasComponent(Entity entity) const {
             return entityData<U>(storage).count(entity);
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstdint>
+#include <random>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
+#include "../memory/FrameArena.hpp"
+#include "Snapshot.hpp"
 
 namespace ecs {
     using Entity = unsigned;
@@ -15,12 +20,47 @@ namespace ecs {
             ComponentData<T> field;
             static constexpr ComponentData<T> FieldContainer::* address = &FieldContainer::field;
         };
+
+        template<typename T>
+        struct SpareNodeContainer {
+            std::vector<typename ComponentData<T>::node_type> nodes;
+        };
     }
 
+    /**
+     * The entities of a world and all their data, which can be copied or
+     * swapped as a whole.
+     *
+     * `chunkRevisions` has a revision per chunk of `SNAPSHOT_CHUNK_SIZE`
+     * consecutive entities (see `GenericWorld::chunkRevisions`). It travels
+     * with the entities, so that data derived from them and stored in the
+     * world stays consistent with it.
+     */
     template<typename... Ts>
-    struct GenericECS : __detail::FieldContainer<Ts>... {
+    struct ComponentStorage : __detail::FieldContainer<Ts>... {
         using ComponentTypes = std::tuple<Ts...>;
         Entity nextEntityId = 0;
+        std::vector<std::uint32_t> chunkRevisions;
+    };
+
+    /**
+     * The nodes of removed components, kept to be reused by the next
+     * components of the same type instead of being freed and allocated
+     * again, e.g when the paddle stops and starts moving. They belong to the
+     * world rather than to its entities, so copying or swapping the storage
+     * leaves them alone.
+     */
+    template<typename... Ts>
+    struct SpareNodes : __detail::SpareNodeContainer<Ts>... { };
+
+    template<typename... Ts>
+    struct GenericECS : ComponentStorage<Ts...> {
+        using Storage = ComponentStorage<Ts...>;
+        using Snapshot = WorldSnapshot<Ts...>;
+        memory::FrameArena frameArena;
+        std::mt19937 randomEngine;
+        SnapshotHistory<Ts...> snapshots;
+        SpareNodes<Ts...> spareNodes;
     };
 
     template<typename T, typename ECS>
@@ -34,4 +74,18 @@ namespace ecs {
         constexpr auto field = __detail::FieldContainer<T>::address;
         return ecs.*field;
     }
+
+    template<typename T, typename ECS>
+    std::vector<typename ComponentData<T>::node_type>& spareNodes(ECS& ecs) {
+        return static_cast<__detail::SpareNodeContainer<T>&>(ecs.spareNodes).nodes;
+    }
+
+    /**
+     * Records that the T component of an entity may have changed, so that
+     * the next snapshot copies it.
+     */
+    template<typename T, typename ECS>
+    void markChanged(ECS& ecs, Entity entity) {
+        ecs.snapshots.template markChanged<T>(entity);
+    }
 }
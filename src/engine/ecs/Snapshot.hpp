@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+    using Entity = unsigned;
+    using SnapshotId = std::uint64_t;
+
+    /**
+     * Number of consecutive entity IDs whose components are copied, and
+     * shared between snapshots, as a unit.
+     */
+    constexpr Entity SNAPSHOT_CHUNK_SIZE = 64;
+
+    /**
+     * Number of consecutive chunks grouped in a page of a chunk table, so
+     * that tables can share pages too.
+     */
+    constexpr std::size_t SNAPSHOT_PAGE_SIZE = 64;
+
+    /**
+     * Number of snapshots kept by a world before the oldest ones are
+     * dropped, e.g 2 seconds of per-tick snapshots at 60 ticks per second.
+     */
+    constexpr std::size_t DEFAULT_SNAPSHOT_CAPACITY = 120;
+
+    /**
+     * The T components of the entities of a chunk, if any, as copied when
+     * a snapshot was saved. Chunks are immutable once built, so snapshots
+     * share them until the entities of the chunk change.
+     */
+    template<typename T>
+    using SnapshotChunk = std::vector<std::pair<Entity, T>>;
+
+    template<typename T>
+    using SnapshotPage = std::array<std::shared_ptr<const SnapshotChunk<T>>, SNAPSHOT_PAGE_SIZE>;
+
+    /**
+     * The T components of a whole world, one chunk per `SNAPSHOT_CHUNK_SIZE`
+     * entity IDs, grouped in pages. Chunks and pages without T components
+     * are null. Taking a snapshot only copies the pages with changed chunks.
+     */
+    template<typename T>
+    using SnapshotChunkTable = std::vector<std::shared_ptr<const SnapshotPage<T>>>;
+
+    template<typename T>
+    const SnapshotChunk<T>* chunkAt(const SnapshotChunkTable<T>& table, std::size_t chunk) {
+        std::size_t page = chunk / SNAPSHOT_PAGE_SIZE;
+
+        if (page >= table.size() || !table[page]) {
+            return nullptr;
+        }
+
+        return (*table[page])[chunk % SNAPSHOT_PAGE_SIZE].get();
+    }
+
+    template<typename T>
+    const SnapshotPage<T>* pageAt(const SnapshotChunkTable<T>& table, std::size_t page) {
+        return (page < table.size()) ? table[page].get() : nullptr;
+    }
+
+    /**
+     * Set of the chunks whose T components may have changed since the last
+     * snapshot was saved or restored, as one bit per chunk and one word
+     * per page.
+     */
+    template<typename T>
+    class DirtyChunks {
+        static_assert(SNAPSHOT_PAGE_SIZE == 64);
+
+     public:
+        void mark(Entity entity) {
+            std::size_t chunk = entity / SNAPSHOT_CHUNK_SIZE;
+            std::size_t page = chunk / SNAPSHOT_PAGE_SIZE;
+
+            if (page >= words.size()) {
+                words.resize(page + 1, 0);
+            }
+
+            words[page] |= std::uint64_t(1) << (chunk % SNAPSHOT_PAGE_SIZE);
+            anyMarked = true;
+        }
+
+        bool test(std::size_t chunk) const {
+            std::size_t page = chunk / SNAPSHOT_PAGE_SIZE;
+            return page < words.size() && (words[page] >> (chunk % SNAPSHOT_PAGE_SIZE)) & 1;
+        }
+
+        bool testPage(std::size_t page) const {
+            return page < words.size() && words[page] != 0;
+        }
+
+        bool empty() const {
+            return !anyMarked;
+        }
+
+        /**
+         * Returns an upper bound of the pages with marked chunks.
+         */
+        std::size_t pageBound() const {
+            return words.size();
+        }
+
+        void clear() {
+            std::fill(words.begin(), words.end(), 0);
+            anyMarked = false;
+        }
+
+     private:
+        std::vector<std::uint64_t> words;
+        bool anyMarked = false;
+    };
+
+    /**
+     * A saved state of a world: the chunk tables of every component type,
+     * the ID generation, the chunk revisions and the random engine. Chunk
+     * revisions are shared with the previous snapshot until they change.
+     */
+    template<typename... Ts>
+    struct WorldSnapshot {
+        SnapshotId id;
+        Entity nextEntityId;
+        std::shared_ptr<const std::vector<std::uint32_t>> chunkRevisions;
+        std::mt19937 randomEngine;
+        std::tuple<std::shared_ptr<const SnapshotChunkTable<Ts>>...> tables;
+    };
+
+    template<typename T, typename... Ts>
+    const SnapshotChunkTable<T>& tableOf(const WorldSnapshot<Ts...>& snapshot) {
+        return *std::get<std::shared_ptr<const SnapshotChunkTable<T>>>(snapshot.tables);
+    }
+
+    /**
+     * The bounded list of snapshots of a world, oldest first, and what is
+     * needed to only copy the changes when taking the next one.
+     *
+     * Changes are tracked relative to `base`, the snapshot that was last
+     * saved or restored. Without a base (before the first snapshot, or
+     * after the storage was replaced as a whole), everything is copied.
+     */
+    template<typename... Ts>
+    struct SnapshotHistory {
+        std::deque<WorldSnapshot<Ts...>> snapshots;
+        std::size_t capacity = DEFAULT_SNAPSHOT_CAPACITY;
+        SnapshotId nextId = 0;
+        std::optional<WorldSnapshot<Ts...>> base;
+        std::tuple<DirtyChunks<Ts>...> dirtyChunks;
+        // Changes are only tracked once a snapshot has been requested
+        bool tracking = false;
+        // Whether the chunk revisions changed since the base
+        bool revisionsChanged = false;
+
+        template<typename T>
+        void markChanged(Entity entity) {
+            if (tracking) {
+                std::get<DirtyChunks<T>>(dirtyChunks).mark(entity);
+            }
+        }
+
+        /**
+         * Forgets the base, e.g because all entities were replaced.
+         */
+        void invalidate() {
+            base.reset();
+        }
+    };
+}
@@ -1,10 +1,42 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../memory/FrameArena.hpp"
 #include "../metaprogramming/for-each-type.hpp"
+#include "../profiling/Profiler.hpp"
 #include "DataQuery.hpp"
 #include "ECS.hpp"
 
 namespace ecs {
+    namespace __detail {
+        /**
+         * Whether a query callback accepts the `I`-th of `Ts` as const while
+         * taking the others as mutable, i.e whether it only reads it.
+         */
+        template<typename Functor, std::size_t I, typename Indices, typename... Ts>
+        struct ReadsOnly;
+
+        template<typename Functor, std::size_t I, std::size_t... Is, typename... Ts>
+        struct ReadsOnly<Functor, I, std::index_sequence<Is...>, Ts...>
+            : std::is_invocable<Functor&, Entity, std::conditional_t<Is == I, const Ts&, Ts&>...> { };
+
+        template<typename Functor, typename... Ts, typename ECS, std::size_t... Is>
+        void markWritten(ECS& storage, Entity entity, std::index_sequence<Is...> indices) {
+            ((ReadsOnly<Functor, Is, decltype(indices), Ts...>::value
+                ? void()
+                : markChanged<Ts>(storage, entity)), ...);
+        }
+    }
+
     /**
      * Manages the game entities and their components.
      *
@@ -16,6 +48,9 @@ namespace ecs {
     template<typename ECS>
     class GenericWorld {
      public:
+        using Storage = typename ECS::Storage;
+        using Snapshot = typename ECS::Snapshot;
+
         /**
          * Creates a new entity with the given components, if any.
          * Returns the ID of the created entity.
@@ -23,6 +58,12 @@ namespace ecs {
         template<typename... Ts>
         Entity createEntity(Ts&&...);
 
+        /**
+         * Creates `count` entities without components, with consecutive IDs.
+         * Returns the ID of the first one.
+         */
+        Entity createEntities(std::size_t count);
+
         /**
          * Deletes an entity, including all its data.
          */
@@ -34,6 +75,72 @@ namespace ecs {
          */
         void clear();
 
+        /**
+         * Copies every entity and all its data into `target`, reusing the
+         * memory it already holds where possible.
+         */
+        void copyStorageTo(Storage& target) const;
+
+        /**
+         * Replaces all entities with the ones of a copy of the storage,
+         * including the ID generation. Unlike `clear` followed by rebuilding
+         * the entities, the storage is copied map by map, reusing the nodes
+         * it already owns instead of freeing and reallocating them. Neither
+         * the frame arena nor the random engine are affected.
+         */
+        void restoreStorage(const Storage& source);
+
+        /**
+         * Exchanges all entities with the ones of another storage, which
+         * gets the current entities in return. Takes constant time.
+         */
+        void swapStorage(Storage& other);
+
+        /**
+         * Takes components out of a storage that is about to be overwritten,
+         * e.g the previous entities after `swapStorage`, to keep their
+         * memory for the next components added to the world. Only takes as
+         * many as there is room for.
+         */
+        void recycleStorage(Storage& discarded);
+
+        /**
+         * Saves the current state of the world (entities, components, ID
+         * generation, chunk revisions and random engine) and returns its ID. Only the
+         * latest `setSnapshotCapacity` snapshots are kept.
+         *
+         * Snapshots are copy-on-write: components are copied in chunks of
+         * `SNAPSHOT_CHUNK_SIZE` entities, and only the chunks that changed
+         * since the previous snapshot are copied again, while the others
+         * are shared. Changes are tracked from the first snapshot on.
+         */
+        SnapshotId saveSnapshot();
+
+        /**
+         * Brings the world back to a snapshot, e.g to resimulate ticks with
+         * corrected input. Only the chunks that differ from the current
+         * state are copied back. Newer snapshots are kept. Throws
+         * `std::out_of_range` if the snapshot is no longer available.
+         */
+        void restoreSnapshot(SnapshotId);
+
+        /**
+         * Checks if a snapshot is still available.
+         */
+        bool hasSnapshot(SnapshotId) const;
+
+        /**
+         * Gives read access to a snapshot, e.g to compare two of them.
+         * Throws `std::out_of_range` if it is no longer available.
+         */
+        const Snapshot& getSnapshot(SnapshotId) const;
+
+        /**
+         * Sets how many snapshots are kept, dropping the oldest ones if
+         * there are more.
+         */
+        void setSnapshotCapacity(std::size_t);
+
         /**
          * Adds a given T component to an entity.
          */
@@ -41,7 +148,23 @@ namespace ecs {
         void addComponent(Entity, T&&);
 
         /**
-         * Removes the T component from an entity.
+         * Bulk version of `addComponent`: copies `count` T components from
+         * a contiguous column into the entities with consecutive IDs
+         * starting at `first`.
+         */
+        template<typename T>
+        void addComponents(Entity first, const T* data, std::size_t count);
+
+        /**
+         * Reserves room for `count` T components in total, so that adding
+         * them doesn't rehash the component storage.
+         */
+        template<typename T>
+        void reserve(std::size_t count);
+
+        /**
+         * Removes the T component from an entity. Its memory is kept, when
+         * there is room, for the next T component added to any entity.
          */
         template<typename T>
         void removeComponent(Entity);
@@ -64,6 +187,30 @@ namespace ecs {
         template<typename... Ts>
         bool hasAllComponents(Entity) const;
 
+        /**
+         * Checks if an entity has at least one component, i.e if it exists
+         * and hasn't been deleted.
+         */
+        bool hasAnyComponent(Entity) const;
+
+        /**
+         * Returns a revision per chunk of `SNAPSHOT_CHUNK_SIZE` consecutive
+         * entities, which changes whenever an entity of the chunk gains,
+         * loses or replaces a component. Snapshots restore them along with
+         * the entities. Chunks past the end never had any component.
+         *
+         * Lets data derived from the entities, e.g render batches, find the
+         * chunks it must rebuild. Changes made in place through `getData`
+         * or queries are not counted.
+         */
+        const std::vector<std::uint32_t>& chunkRevisions() const;
+
+        /**
+         * Returns the number of entities that have a T component.
+         */
+        template<typename T>
+        std::size_t count() const;
+
         /**
          * Returns the T component data of an entity. Throws if
          * the entity doesn't have the T component.
@@ -71,6 +218,13 @@ namespace ecs {
         template<typename T>
         T& getData(Entity);
 
+        /**
+         * Read-only access to the T component data of an entity, which,
+         * unlike the mutable one, doesn't mark it as changed for snapshots.
+         */
+        template<typename T>
+        const T& getData(Entity) const;
+
         /**
          * Iterates over all entities that have all the input components,
          * executing a callback for each of them.
@@ -94,8 +248,9 @@ namespace ecs {
         /**
          * Functionally equal to `query`, but allows the input function to
          * mutate the components of the iterated entities. This is achieved
-         * through an extra copy, and may have performance implications if
-         * many entities have the T component.
+         * by snapshotting the IDs of the entities with the T component into
+         * the frame arena. Entities that lose any of the input components
+         * during the iteration are skipped.
          */
         template<typename T, typename... Ts, typename Functor>
         void mutatingQuery(Functor);
@@ -121,9 +276,52 @@ namespace ecs {
         template<typename T>
         GenericDataQuery<ECS, Desirable<T>, Undesirable<>> findAll();
 
+        /**
+         * Returns the linear allocator used for scratch data that only lives
+         * during the current frame, e.g `std::pmr::vector`s of collisions.
+         * Whoever drives the frame must `reset` it once the frame is over.
+         */
+        memory::FrameArena& frameArena();
+
+        /**
+         * Returns the random number generator of the world. It is the only
+         * source of randomness allowed in systems, so that a run can be
+         * reproduced by seeding it with the same value. It isn't reset
+         * by `clear`.
+         */
+        std::mt19937& randomEngine();
+
      private:
         ECS storage;
 
+        /**
+         * Marks the components passed to a query callback as changed,
+         * except the ones that it accepts as const.
+         */
+        template<typename T, typename... Ts, typename Functor>
+        void markQueried(Functor&, Entity);
+
+        /**
+         * Bumps the revisions of the chunks of `count` consecutive entities
+         * starting at `first`.
+         */
+        void touchChunks(Entity first, std::size_t count = 1);
+
+        /**
+         * Inserts a T component, reusing a spare node if there is one.
+         */
+        template<typename T, typename U>
+        void insertComponent(Entity, U&&);
+
+        template<typename T>
+        std::shared_ptr<const SnapshotChunkTable<T>> snapshotTable();
+
+        template<typename T>
+        std::shared_ptr<const SnapshotChunk<T>> copyChunk(std::size_t chunk);
+
+        template<typename T>
+        void restoreTable(const std::shared_ptr<const SnapshotChunkTable<T>>&);
+
         template<typename T, typename... Ts, typename Functor>
         void internalQuery(Functor, ComponentData<T>&);
     };
@@ -132,13 +330,24 @@ namespace ecs {
     template<typename ECS>
     template<typename... Ts>
     inline Entity GenericWorld<ECS>::createEntity(Ts&&... data) {
+        PROFILE_SCOPE("World::createEntity");
+
         Entity id = storage.nextEntityId++;
         (addComponent<Ts>(id, std::forward<Ts>(data)), ...);
         return id;
     }
 
+    template<typename ECS>
+    inline Entity GenericWorld<ECS>::createEntities(std::size_t count) {
+        Entity first = storage.nextEntityId;
+        storage.nextEntityId += count;
+        return first;
+    }
+
     template<typename ECS>
     inline void GenericWorld<ECS>::deleteEntity(Entity entity) {
+        PROFILE_SCOPE("World::deleteEntity");
+
         auto fn = [this, entity]<typename T>() {
             removeComponent<T>(entity);
         };
@@ -148,36 +357,207 @@ namespace ecs {
 
     template<typename ECS>
     inline void GenericWorld<ECS>::clear() {
+        PROFILE_SCOPE("World::clear");
+
         auto fn = [this]<typename T>() {
             entityData<T>(storage).clear();
         };
 
         meta::forEachT<typename ECS::ComponentTypes>(fn);
+        touchChunks(0, storage.chunkRevisions.size() * SNAPSHOT_CHUNK_SIZE);
         storage.nextEntityId = 0;
+        storage.snapshots.invalidate();
+    }
+
+    template<typename ECS>
+    inline void GenericWorld<ECS>::copyStorageTo(Storage& target) const {
+        PROFILE_SCOPE("World::copyStorageTo");
+
+        target = static_cast<const Storage&>(storage);
+    }
+
+    template<typename ECS>
+    inline void GenericWorld<ECS>::restoreStorage(const Storage& source) {
+        PROFILE_SCOPE("World::restoreStorage");
+
+        static_cast<Storage&>(storage) = source;
+        storage.snapshots.invalidate();
+    }
+
+    template<typename ECS>
+    inline void GenericWorld<ECS>::swapStorage(Storage& other) {
+        std::swap(static_cast<Storage&>(storage), other);
+        storage.snapshots.invalidate();
+    }
+
+    template<typename ECS>
+    inline void GenericWorld<ECS>::recycleStorage(Storage& discarded) {
+        PROFILE_SCOPE("World::recycleStorage");
+
+        auto fn = [this, &discarded]<typename T>() {
+            ComponentData<T>& components = entityData<T>(discarded);
+            auto& spare = spareNodes<T>(storage);
+
+            while (!components.empty() && spare.size() < spare.capacity()) {
+                spare.push_back(components.extract(components.begin()));
+            }
+        };
+
+        meta::forEachT<typename ECS::ComponentTypes>(fn);
+    }
+
+    template<typename ECS>
+    inline SnapshotId GenericWorld<ECS>::saveSnapshot() {
+        PROFILE_SCOPE("World::saveSnapshot");
+
+        auto& history = storage.snapshots;
+        history.tracking = true;
+
+        typename decltype(history.snapshots)::value_type snapshot;
+        snapshot.id = history.nextId++;
+        snapshot.nextEntityId = storage.nextEntityId;
+        snapshot.randomEngine = storage.randomEngine;
+
+        if (history.base && !history.revisionsChanged) {
+            snapshot.chunkRevisions = history.base->chunkRevisions;
+        } else {
+            snapshot.chunkRevisions = std::make_shared<const std::vector<std::uint32_t>>(storage.chunkRevisions);
+        }
+
+        history.revisionsChanged = false;
+
+        auto fn = [this, &snapshot]<typename T>() {
+            std::get<std::shared_ptr<const SnapshotChunkTable<T>>>(snapshot.tables) = snapshotTable<T>();
+        };
+
+        meta::forEachT<typename ECS::ComponentTypes>(fn);
+
+        history.base = snapshot;
+        history.snapshots.push_back(std::move(snapshot));
+
+        while (history.snapshots.size() > history.capacity) {
+            history.snapshots.pop_front();
+        }
+
+        return history.base->id;
+    }
+
+    template<typename ECS>
+    inline void GenericWorld<ECS>::restoreSnapshot(SnapshotId id) {
+        PROFILE_SCOPE("World::restoreSnapshot");
+
+        auto& history = storage.snapshots;
+        const Snapshot& snapshot = getSnapshot(id);
+
+        auto fn = [this, &snapshot]<typename T>() {
+            restoreTable<T>(std::get<std::shared_ptr<const SnapshotChunkTable<T>>>(snapshot.tables));
+        };
+
+        meta::forEachT<typename ECS::ComponentTypes>(fn);
+
+        storage.nextEntityId = snapshot.nextEntityId;
+        storage.chunkRevisions = *snapshot.chunkRevisions;
+        storage.randomEngine = snapshot.randomEngine;
+        history.base = snapshot;
+        history.revisionsChanged = false;
+    }
+
+    template<typename ECS>
+    inline bool GenericWorld<ECS>::hasSnapshot(SnapshotId id) const {
+        const auto& snapshots = storage.snapshots.snapshots;
+        return !snapshots.empty() && id >= snapshots.front().id && id <= snapshots.back().id;
+    }
+
+    template<typename ECS>
+    inline auto GenericWorld<ECS>::getSnapshot(SnapshotId id) const -> const Snapshot& {
+        if (!hasSnapshot(id)) {
+            throw std::out_of_range("snapshot no longer available");
+        }
+
+        const auto& snapshots = storage.snapshots.snapshots;
+        return snapshots[id - snapshots.front().id];
+    }
+
+    template<typename ECS>
+    inline void GenericWorld<ECS>::setSnapshotCapacity(std::size_t capacity) {
+        auto& history = storage.snapshots;
+        history.capacity = capacity;
+
+        while (history.snapshots.size() > capacity) {
+            history.snapshots.pop_front();
+        }
     }
 
     template<typename ECS>
     template<typename T>
     inline void GenericWorld<ECS>::addComponent(Entity entity, T&& data) {
-        entityData<std::decay_t<T>>(storage).insert({
-            entity,
-            std::forward<T>(data)
-        });
+        PROFILE_SCOPE("World::addComponent");
+
+        markChanged<std::decay_t<T>>(storage, entity);
+        touchChunks(entity);
+        insertComponent<std::decay_t<T>>(entity, std::forward<T>(data));
+    }
+
+    template<typename ECS>
+    template<typename T>
+    inline void GenericWorld<ECS>::addComponents(Entity first, const T* data, std::size_t count) {
+        PROFILE_SCOPE("World::addComponents");
+
+        ComponentData<T>& components = entityData<T>(storage);
+        components.reserve(components.size() + count);
+        touchChunks(first, count);
+
+        for (std::size_t i = 0; i < count; i++) {
+            Entity entity = first + i;
+            markChanged<T>(storage, entity);
+            insertComponent<T>(entity, data[i]);
+        }
+    }
+
+    template<typename ECS>
+    template<typename T>
+    inline void GenericWorld<ECS>::reserve(std::size_t count) {
+        entityData<T>(storage).reserve(count);
     }
 
     template<typename ECS>
     template<typename T>
     inline void GenericWorld<ECS>::removeComponent(Entity entity) {
-        entityData<T>(storage).erase(entity);
+        PROFILE_SCOPE("World::removeComponent");
+
+        markChanged<T>(storage, entity);
+
+        auto node = entityData<T>(storage).extract(entity);
+
+        if (!node) {
+            return;
+        }
+
+        touchChunks(entity);
+        auto& spare = spareNodes<T>(storage);
+
+        // The node is freed instead when keeping it would allocate
+        if (spare.size() < spare.capacity()) {
+            spare.push_back(std::move(node));
+        }
     }
 
     template<typename ECS>
     template<typename T>
     inline void GenericWorld<ECS>::replaceComponent(Entity entity, T&& data) {
-        entityData<std::decay_t<T>>(storage).insert_or_assign(
-            entity,
-            std::forward<T>(data)
-        );
+        PROFILE_SCOPE("World::replaceComponent");
+
+        markChanged<std::decay_t<T>>(storage, entity);
+        touchChunks(entity);
+
+        ComponentData<std::decay_t<T>>& components = entityData<std::decay_t<T>>(storage);
+        auto it = components.find(entity);
+
+        if (it != components.end()) {
+            it->second = std::forward<T>(data);
+        } else {
+            insertComponent<std::decay_t<T>>(entity, std::forward<T>(data));
+        }
     }
 
     template<typename ECS>
@@ -192,9 +572,86 @@ namespace ecs {
         return (hasComponent<Ts>(entity) && ...);
     }
 
+    template<typename ECS>
+    inline bool GenericWorld<ECS>::hasAnyComponent(Entity entity) const {
+        bool result = false;
+
+        auto fn = [this, entity, &result]<typename T>() {
+            result = result || hasComponent<T>(entity);
+        };
+
+        meta::forEachT<typename ECS::ComponentTypes>(fn);
+        return result;
+    }
+
+    template<typename ECS>
+    inline const std::vector<std::uint32_t>& GenericWorld<ECS>::chunkRevisions() const {
+        return storage.chunkRevisions;
+    }
+
+    template<typename ECS>
+    inline void GenericWorld<ECS>::touchChunks(Entity first, std::size_t count) {
+        if (count == 0) {
+            return;
+        }
+
+        auto& revisions = storage.chunkRevisions;
+        storage.snapshots.revisionsChanged = true;
+
+        std::size_t firstChunk = first / SNAPSHOT_CHUNK_SIZE;
+        std::size_t lastChunk = (first + count - 1) / SNAPSHOT_CHUNK_SIZE;
+
+        if (lastChunk >= revisions.size()) {
+            revisions.resize(lastChunk + 1, 0);
+        }
+
+        for (std::size_t chunk = firstChunk; chunk <= lastChunk; chunk++) {
+            revisions[chunk]++;
+        }
+    }
+
+    template<typename ECS>
+    template<typename T, typename U>
+    inline void GenericWorld<ECS>::insertComponent(Entity entity, U&& data) {
+        auto& spare = spareNodes<T>(storage);
+
+        if (spare.empty()) {
+            ComponentData<T>& components = entityData<T>(storage);
+            components.insert({ entity, std::forward<U>(data) });
+
+            // Grown along with the buckets, so that there is room to keep
+            // the nodes of removed components
+            spare.reserve(components.bucket_count());
+            return;
+        }
+
+        auto node = std::move(spare.back());
+        spare.pop_back();
+        node.key() = entity;
+        node.mapped() = std::forward<U>(data);
+        auto result = entityData<T>(storage).insert(std::move(node));
+
+        if (!result.inserted) {
+            spare.push_back(std::move(result.node));
+        }
+    }
+
+    template<typename ECS>
+    template<typename T>
+    inline std::size_t GenericWorld<ECS>::count() const {
+        return entityData<T>(storage).size();
+    }
+
     template<typename ECS>
     template<typename T>
     inline T& GenericWorld<ECS>::getData(Entity entity) {
+        markChanged<T>(storage, entity);
+        return entityData<T>(storage).at(entity);
+    }
+
+    template<typename ECS>
+    template<typename T>
+    inline const T& GenericWorld<ECS>::getData(Entity entity) const {
         return entityData<T>(storage).at(entity);
     }
 
@@ -208,16 +665,31 @@ namespace ecs {
     template<typename ECS>
     template<typename T, typename... Ts, typename Functor>
     inline void GenericWorld<ECS>::mutatingQuery(Functor fn) {
-        // Makes a copy due to potential iterator invalidation
-        ComponentData<T> baseData = entityData<T>(storage);
-        internalQuery<T, Ts...>(fn, baseData);
+        // Snapshots the IDs due to potential iterator invalidation
+        ComponentData<T>& baseData = entityData<T>(storage);
+        std::pmr::vector<Entity> entities(&storage.frameArena);
+        entities.reserve(baseData.size());
+
+        for (auto& [entity, data] : baseData) {
+            entities.push_back(entity);
+        }
+
+        for (Entity entity : entities) {
+            if (hasAllComponents<T, Ts...>(entity)) {
+                markQueried<T, Ts...>(fn, entity);
+                ComponentData<T>& data = entityData<T>(storage);
+                fn(entity, data.at(entity), entityData<Ts>(storage).at(entity)...);
+            }
+        }
     }
 
     template<typename ECS>
     template<typename T, typename... Args>
     inline void GenericWorld<ECS>::notify(Args&&... args) {
-        mutatingQuery<T>([&](Entity, T& listener) {
-            listener.fn(std::forward<Args>(args)...);
+        mutatingQuery<T>([&](Entity, const T& listener) {
+            // The listener may delete itself, so it must not run in-place
+            auto fn = listener.fn;
+            fn(std::forward<Args>(args)...);
         });
     }
 
@@ -235,19 +707,194 @@ namespace ecs {
         return GenericDataQuery<ECS, Desirable<T>, Undesirable<>>(storage);
     }
 
+    template<typename ECS>
+    inline memory::FrameArena& GenericWorld<ECS>::frameArena() {
+        return storage.frameArena;
+    }
+
+    template<typename ECS>
+    inline std::mt19937& GenericWorld<ECS>::randomEngine() {
+        return storage.randomEngine;
+    }
+
     template<typename ECS>
     template<typename T, typename... Ts, typename Functor>
     inline void GenericWorld<ECS>::internalQuery(Functor fn, ComponentData<T>& baseData) {
         if constexpr (sizeof...(Ts) > 0) {
             for (auto& [entity, data] : baseData) {
                 if (hasAllComponents<Ts...>(entity)) {
-                    fn(entity, data, getData<Ts>(entity)...);
+                    markQueried<T, Ts...>(fn, entity);
+                    fn(entity, data, entityData<Ts>(storage).at(entity)...);
                 }
             }
         } else {
             for (auto& [entity, data] : baseData) {
+                markQueried<T>(fn, entity);
                 fn(entity, data);
             }
         }
     }
+
+    template<typename ECS>
+    template<typename T, typename... Ts, typename Functor>
+    inline void GenericWorld<ECS>::markQueried(Functor&, Entity entity) {
+        __detail::markWritten<Functor, T, Ts...>(storage, entity, std::index_sequence_for<T, Ts...>());
+    }
+
+    template<typename ECS>
+    template<typename T>
+    inline std::shared_ptr<const SnapshotChunkTable<T>> GenericWorld<ECS>::snapshotTable() {
+        auto& history = storage.snapshots;
+        auto& dirty = std::get<DirtyChunks<T>>(history.dirtyChunks);
+        std::size_t chunkCount = (storage.nextEntityId + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE;
+        std::size_t pageCount = (chunkCount + SNAPSHOT_PAGE_SIZE - 1) / SNAPSHOT_PAGE_SIZE;
+
+        if (!history.base) {
+            // Without a base, a single pass over the components fills all chunks
+            std::vector<SnapshotChunk<T>> chunks(chunkCount);
+
+            for (const auto& [entity, data] : entityData<T>(storage)) {
+                chunks[entity / SNAPSHOT_CHUNK_SIZE].emplace_back(entity, data);
+            }
+
+            auto table = std::make_shared<SnapshotChunkTable<T>>(pageCount);
+            std::shared_ptr<SnapshotPage<T>> page;
+
+            for (std::size_t i = 0; i < chunkCount; i++) {
+                if (i % SNAPSHOT_PAGE_SIZE == 0) {
+                    page = nullptr;
+                }
+
+                if (chunks[i].empty()) {
+                    continue;
+                }
+
+                if (!page) {
+                    page = std::make_shared<SnapshotPage<T>>();
+                    (*table)[i / SNAPSHOT_PAGE_SIZE] = page;
+                }
+
+                (*page)[i % SNAPSHOT_PAGE_SIZE] = std::make_shared<const SnapshotChunk<T>>(std::move(chunks[i]));
+            }
+
+            dirty.clear();
+            return table;
+        }
+
+        const auto& baseTable = std::get<std::shared_ptr<const SnapshotChunkTable<T>>>(history.base->tables);
+
+        if (dirty.empty()) {
+            return baseTable;
+        }
+
+        auto table = std::make_shared<SnapshotChunkTable<T>>(pageCount);
+
+        for (std::size_t i = 0; i < pageCount; i++) {
+            const SnapshotPage<T>* basePage = pageAt(*baseTable, i);
+
+            if (!dirty.testPage(i)) {
+                (*table)[i] = (i < baseTable->size()) ? (*baseTable)[i] : nullptr;
+                continue;
+            }
+
+            auto page = basePage
+                ? std::make_shared<SnapshotPage<T>>(*basePage)
+                : std::make_shared<SnapshotPage<T>>();
+
+            for (std::size_t j = 0; j < SNAPSHOT_PAGE_SIZE; j++) {
+                std::size_t chunk = i * SNAPSHOT_PAGE_SIZE + j;
+
+                if (dirty.test(chunk)) {
+                    (*page)[j] = copyChunk<T>(chunk);
+                }
+            }
+
+            (*table)[i] = std::move(page);
+        }
+
+        dirty.clear();
+        return table;
+    }
+
+    template<typename ECS>
+    template<typename T>
+    inline std::shared_ptr<const SnapshotChunk<T>> GenericWorld<ECS>::copyChunk(std::size_t chunk) {
+        const ComponentData<T>& components = entityData<T>(storage);
+        Entity first = chunk * SNAPSHOT_CHUNK_SIZE;
+        Entity last = std::min<Entity>(first + SNAPSHOT_CHUNK_SIZE, storage.nextEntityId);
+        SnapshotChunk<T> result;
+
+        for (Entity entity = first; entity < last; entity++) {
+            auto it = components.find(entity);
+
+            if (it != components.end()) {
+                result.emplace_back(entity, it->second);
+            }
+        }
+
+        if (result.empty()) {
+            return nullptr;
+        }
+
+        return std::make_shared<const SnapshotChunk<T>>(std::move(result));
+    }
+
+    template<typename ECS>
+    template<typename T>
+    inline void GenericWorld<ECS>::restoreTable(
+        const std::shared_ptr<const SnapshotChunkTable<T>>& table
+    ) {
+        auto& history = storage.snapshots;
+        auto& dirty = std::get<DirtyChunks<T>>(history.dirtyChunks);
+        ComponentData<T>& components = entityData<T>(storage);
+
+        if (!history.base) {
+            components.clear();
+
+            for (const auto& page : *table) {
+                for (std::size_t j = 0; page && j < SNAPSHOT_PAGE_SIZE; j++) {
+                    if (const auto& chunk = (*page)[j]) {
+                        components.insert(chunk->begin(), chunk->end());
+                    }
+                }
+            }
+
+            dirty.clear();
+            return;
+        }
+
+        const auto& baseTable = std::get<std::shared_ptr<const SnapshotChunkTable<T>>>(history.base->tables);
+
+        if (baseTable == table && dirty.empty()) {
+            return;
+        }
+
+        std::size_t pageCount = std::max({ baseTable->size(), table->size(), dirty.pageBound() });
+
+        for (std::size_t i = 0; i < pageCount; i++) {
+            if (!dirty.testPage(i) && pageAt(*baseTable, i) == pageAt(*table, i)) {
+                continue;
+            }
+
+            for (std::size_t j = 0; j < SNAPSHOT_PAGE_SIZE; j++) {
+                std::size_t chunk = i * SNAPSHOT_PAGE_SIZE + j;
+                const SnapshotChunk<T>* target = chunkAt(*table, chunk);
+
+                if (!dirty.test(chunk) && chunkAt(*baseTable, chunk) == target) {
+                    continue;
+                }
+
+                Entity first = chunk * SNAPSHOT_CHUNK_SIZE;
+                for (Entity entity = first; entity < first + SNAPSHOT_CHUNK_SIZE; entity++) {
+                    components.erase(entity);
+                }
+
+                if (target) {
+                    components.insert(target->begin(), target->end());
+                }
+            }
+        }
+
+        dirty.clear();
+    }
 }
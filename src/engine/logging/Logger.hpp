@@ -0,0 +1,328 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "../threading/SpscRing.hpp"
+
+/**
+ * Lowest level that is compiled in: 0 (trace) to 4 (error), or 5 to
+ * compile out all logging. Set by the meson option `log_level`.
+ */
+#ifndef ARKANOID_LOG_LEVEL
+    #define ARKANOID_LOG_LEVEL 2
+#endif
+
+namespace logging {
+    enum class Level : std::uint8_t {
+        Trace,
+        Debug,
+        Info,
+        Warn,
+        Error,
+    };
+
+    /**
+     * An argument of a log record, stored as-is so that formatting can be
+     * deferred to the logging thread. Strings are stored as pointers, so
+     * they must outlive the logger (e.g string literals).
+     */
+    struct Argument {
+        enum class Type : std::uint8_t { Signed, Unsigned, Floating, String };
+
+        Type type;
+        union {
+            std::int64_t signedValue;
+            std::uint64_t unsignedValue;
+            double floatingValue;
+            const char* stringValue;
+        };
+
+        Argument() = default;
+
+        template<typename T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, int> = 0>
+        Argument(T value) : type(Type::Signed), signedValue(value) { }
+
+        template<typename T, std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T>, int> = 0>
+        Argument(T value) : type(Type::Unsigned), unsignedValue(value) { }
+
+        template<typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+        Argument(T value) : type(Type::Floating), floatingValue(value) { }
+
+        Argument(const char* value) : type(Type::String), stringValue(value) { }
+    };
+
+    /**
+     * Binary log record. `format` must be a string literal, in which every
+     * `{}` is replaced by the next argument.
+     */
+    struct Record {
+        static constexpr std::size_t MAX_ARGUMENTS = 4;
+
+        Level level;
+        std::uint8_t argumentCount;
+        const char* format;
+        std::int64_t timestamp;
+        Argument arguments[MAX_ARGUMENTS];
+    };
+
+    /**
+     * Asynchronous logger. Logging threads only copy a `Record` into
+     * their own lock-free ring, while a background thread formats the
+     * records and writes them out. Records that don't fit in a full ring
+     * are dropped and counted instead of blocking the caller.
+     *
+     * Use it through the `LOG_*` macros, which compile out the levels below
+     * `ARKANOID_LOG_LEVEL`. There is a single logger, `instance()`, since
+     * each thread caches its ring in a thread-local pointer.
+     */
+    class Logger {
+     public:
+        static constexpr std::size_t RING_CAPACITY = 1 << 12;
+
+        static Logger& instance();
+
+        ~Logger();
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
+        template<typename... Args>
+        void log(Level, const char* format, Args... args);
+
+        /**
+         * Gives the calling thread its ring, which it otherwise allocates
+         * on its first record. Threads that may log where allocating isn't
+         * allowed, e.g inside systems under strict allocation tracking,
+         * register up front.
+         */
+        void registerThread();
+
+        /**
+         * Blocks until every record logged so far has been written.
+         */
+        void flush();
+
+     private:
+        using Clock = std::chrono::steady_clock;
+
+        struct ThreadRing {
+            threading::SpscRing<Record, RING_CAPACITY> records;
+            std::atomic<std::size_t> dropped { 0 };
+        };
+
+        std::ostream& output;
+        const Clock::time_point epoch = Clock::now();
+
+        std::mutex ringsMutex;
+        std::vector<std::unique_ptr<ThreadRing>> rings;
+
+        std::mutex wakeUpMutex;
+        std::condition_variable wakeUp;
+        bool stopping = false;
+        std::atomic<std::uint64_t> flushRequests { 0 };
+        std::atomic<std::uint64_t> flushesDone { 0 };
+        std::thread thread;
+
+        explicit Logger(std::ostream& output);
+
+        ThreadRing& localRing();
+        void work();
+        bool drain();
+        void write(const Record&);
+        void write(const Argument&);
+    };
+
+    inline Logger& Logger::instance() {
+        static Logger logger(std::clog);
+        return logger;
+    }
+
+    inline Logger::Logger(std::ostream& output)
+     : output(output), thread([this] { work(); }) { }
+
+    inline Logger::~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(wakeUpMutex);
+            stopping = true;
+        }
+
+        wakeUp.notify_one();
+        thread.join();
+    }
+
+    template<typename... Args>
+    inline void Logger::log(Level level, const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= Record::MAX_ARGUMENTS, "too many log arguments");
+
+        auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch);
+        Record record { level, sizeof...(Args), format, timestamp.count(), { Argument(args)... } };
+
+        ThreadRing& ring = localRing();
+        if (!ring.records.push(record)) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    inline void Logger::registerThread() {
+        localRing();
+    }
+
+    inline void Logger::flush() {
+        std::uint64_t request = flushRequests.fetch_add(1) + 1;
+        wakeUp.notify_one();
+
+        while (flushesDone.load() < request) {
+            std::this_thread::yield();
+        }
+    }
+
+    inline Logger::ThreadRing& Logger::localRing() {
+        // Rings live as long as the logger, so that the records of threads
+        // that already finished are still written
+        thread_local ThreadRing* ring = nullptr;
+
+        if (!ring) {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.push_back(std::make_unique<ThreadRing>());
+            ring = rings.back().get();
+        }
+
+        return *ring;
+    }
+
+    inline void Logger::work() {
+        using namespace std::chrono_literals;
+
+        while (true) {
+            std::uint64_t requests = flushRequests.load();
+            bool wroteAnything = drain();
+
+            if (wroteAnything) {
+                output.flush();
+            }
+
+            flushesDone.store(requests);
+
+            std::unique_lock<std::mutex> lock(wakeUpMutex);
+            if (stopping) {
+                break;
+            }
+
+            if (!wroteAnything) {
+                wakeUp.wait_for(lock, 10ms);
+            }
+        }
+
+        drain();
+        output.flush();
+    }
+
+    inline bool Logger::drain() {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        bool wroteAnything = false;
+
+        for (auto& ring : rings) {
+            ring->records.drain([this, &wroteAnything](const Record& record) {
+                write(record);
+                wroteAnything = true;
+            });
+
+            if (std::size_t dropped = ring->dropped.exchange(0)) {
+                output << "[logger] " << dropped << " records dropped\n";
+                wroteAnything = true;
+            }
+        }
+
+        return wroteAnything;
+    }
+
+    inline void Logger::write(const Record& record) {
+        static const char* LEVEL_NAMES[] = { "trace", "debug", "info", "warn", "error" };
+
+        output << '[' << record.timestamp / 1e9 << "] "
+               << '[' << LEVEL_NAMES[static_cast<int>(record.level)] << "] ";
+
+        std::size_t argument = 0;
+
+        for (const char* c = record.format; *c; c++) {
+            if (c[0] == '{' && c[1] == '}' && argument < record.argumentCount) {
+                write(record.arguments[argument++]);
+                c++;
+            } else {
+                output << *c;
+            }
+        }
+
+        output << '\n';
+    }
+
+    inline void Logger::write(const Argument& argument) {
+        switch (argument.type) {
+            case Argument::Type::Signed:
+                output << argument.signedValue;
+                break;
+            case Argument::Type::Unsigned:
+                output << argument.unsignedValue;
+                break;
+            case Argument::Type::Floating:
+                output << argument.floatingValue;
+                break;
+            case Argument::Type::String:
+                output << argument.stringValue;
+                break;
+        }
+    }
+}
+
+/**
+ * `LOG_INFO("Collision with {}", id)` and so on. Levels below
+ * `ARKANOID_LOG_LEVEL` expand to nothing, arguments included.
+ *
+ * `LOG_REGISTER_THREAD()` calls `registerThread`, unless logging is
+ * compiled out entirely.
+ */
+#if ARKANOID_LOG_LEVEL <= 4
+    #define LOG_REGISTER_THREAD() ::logging::Logger::instance().registerThread()
+#else
+    #define LOG_REGISTER_THREAD() ((void) 0)
+#endif
+
+#if ARKANOID_LOG_LEVEL <= 0
+    #define LOG_TRACE(...) ::logging::Logger::instance().log(::logging::Level::Trace, __VA_ARGS__)
+#else
+    #define LOG_TRACE(...) ((void) 0)
+#endif
+
+#if ARKANOID_LOG_LEVEL <= 1
+    #define LOG_DEBUG(...) ::logging::Logger::instance().log(::logging::Level::Debug, __VA_ARGS__)
+#else
+    #define LOG_DEBUG(...) ((void) 0)
+#endif
+
+#if ARKANOID_LOG_LEVEL <= 2
+    #define LOG_INFO(...) ::logging::Logger::instance().log(::logging::Level::Info, __VA_ARGS__)
+#else
+    #define LOG_INFO(...) ((void) 0)
+#endif
+
+#if ARKANOID_LOG_LEVEL <= 3
+    #define LOG_WARN(...) ::logging::Logger::instance().log(::logging::Level::Warn, __VA_ARGS__)
+#else
+    #define LOG_WARN(...) ((void) 0)
+#endif
+
+#if ARKANOID_LOG_LEVEL <= 4
+    #define LOG_ERROR(...) ::logging::Logger::instance().log(::logging::Level::Error, __VA_ARGS__)
+#else
+    #define LOG_ERROR(...) ((void) 0)
+#endif
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+
+namespace memory {
+    /**
+     * Counts the heap allocations of every system, as reported by the
+     * global `operator new` replacements of `allocation-hooks.cpp`, which
+     * are only built with the meson option `allocation_tracking`.
+     *
+     * Allocations are attributed to the innermost `AllocationScope` of the
+     * allocating thread. Scopes are kept in a fixed table, so that nothing
+     * here ever allocates, which would recurse into the hooks.
+     *
+     * In strict mode, any allocation made inside a scope by the thread that
+     * enabled it aborts the program with the name of the scope, which is
+     * how steady-state ticks are kept allocation-free. State transitions,
+     * e.g swapping the next level in, aren't part of the steady state and
+     * are exempt (see `ALLOW_ALLOCATIONS`). Allocations outside scopes are
+     * only counted, under "(outside systems)": they come from the driver
+     * loop, e.g `PROFILE_COLLECT()` storing the samples of the frame when
+     * profiling is enabled too. Other threads, e.g the logger and the
+     * render thread, aren't affected.
+     */
+    class AllocationTracker {
+     public:
+        static constexpr std::size_t MAX_SCOPES = 64;
+
+        struct Scope {
+            std::atomic<const char*> name { nullptr };
+            std::atomic<std::uint64_t> frameCount { 0 };
+            std::atomic<std::uint64_t> frameBytes { 0 };
+
+            // Only touched by `endFrame` and `writeReport`
+            std::uint64_t totalCount = 0;
+            std::uint64_t totalBytes = 0;
+            std::uint64_t maxFrameCount = 0;
+        };
+
+        static Scope& scopeFor(const char* name);
+        static Scope*& currentScope();
+        static bool& strictMode();
+        static unsigned& allowedDepth();
+
+        static void recordAllocation(std::size_t bytes);
+
+        /**
+         * Closes the current frame, accumulating its counters into the
+         * totals. Must be called once per tick by the simulation driver.
+         */
+        static void endFrame();
+
+        /**
+         * Enables or disables strict mode for the calling thread. Only
+         * allocations inside scopes abort.
+         */
+        static void setStrict(bool);
+
+        /**
+         * Writes the average and maximum allocations per frame of every
+         * scope that allocated at all.
+         */
+        static void writeReport(std::ostream&);
+
+     private:
+        struct Table {
+            std::array<Scope, MAX_SCOPES> scopes;
+            std::uint64_t frames = 0;
+        };
+
+        static Table& table();
+    };
+
+    /**
+     * Attributes the allocations of the current thread to `name` until
+     * destroyed. `name` must be a string literal.
+     */
+    class AllocationScope {
+     public:
+        explicit AllocationScope(const char* name)
+         : previous(AllocationTracker::currentScope()) {
+            AllocationTracker::currentScope() = &AllocationTracker::scopeFor(name);
+        }
+
+        ~AllocationScope() {
+            AllocationTracker::currentScope() = previous;
+        }
+
+     private:
+        AllocationTracker::Scope* previous;
+    };
+
+    /**
+     * Keeps strict mode from aborting on the allocations of the current
+     * thread until destroyed, including those of the scopes opened
+     * meanwhile, which still count them.
+     */
+    class AllowedAllocations {
+     public:
+        AllowedAllocations() {
+            AllocationTracker::allowedDepth()++;
+        }
+
+        ~AllowedAllocations() {
+            AllocationTracker::allowedDepth()--;
+        }
+    };
+
+    inline AllocationTracker::Table& AllocationTracker::table() {
+        static Table table;
+        return table;
+    }
+
+    inline AllocationTracker::Scope& AllocationTracker::scopeFor(const char* name) {
+        auto& scopes = table().scopes;
+
+        // Open addressing on the address of the literal; the last slot
+        // collects everything once the table is full
+        std::size_t start = reinterpret_cast<std::uintptr_t>(name) % (MAX_SCOPES - 1);
+
+        for (std::size_t i = 0; i < MAX_SCOPES - 1; i++) {
+            Scope& scope = scopes[(start + i) % (MAX_SCOPES - 1)];
+            const char* expected = nullptr;
+
+            if (scope.name.compare_exchange_strong(expected, name) || expected == name) {
+                return scope;
+            }
+        }
+
+        Scope& overflow = scopes[MAX_SCOPES - 1];
+        overflow.name = "(other scopes)";
+        return overflow;
+    }
+
+    inline AllocationTracker::Scope*& AllocationTracker::currentScope() {
+        thread_local Scope* scope = nullptr;
+        return scope;
+    }
+
+    inline bool& AllocationTracker::strictMode() {
+        thread_local bool strict = false;
+        return strict;
+    }
+
+    inline unsigned& AllocationTracker::allowedDepth() {
+        thread_local unsigned depth = 0;
+        return depth;
+    }
+
+    inline void AllocationTracker::recordAllocation(std::size_t bytes) {
+        Scope* scope = currentScope();
+        bool inSystem = scope != nullptr;
+
+        if (!inSystem) {
+            scope = &scopeFor("(outside systems)");
+        }
+
+        if (inSystem && strictMode() && allowedDepth() == 0) {
+            char message[256];
+            std::snprintf(
+                message,
+                sizeof(message),
+                "strict allocation mode: %zu bytes allocated in %s\n",
+                bytes,
+                scope->name.load()
+            );
+            std::fputs(message, stderr);
+            std::abort();
+        }
+
+        scope->frameCount.fetch_add(1, std::memory_order_relaxed);
+        scope->frameBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    inline void AllocationTracker::endFrame() {
+        for (Scope& scope : table().scopes) {
+            std::uint64_t count = scope.frameCount.exchange(0);
+            scope.totalCount += count;
+            scope.totalBytes += scope.frameBytes.exchange(0);
+            scope.maxFrameCount = std::max(scope.maxFrameCount, count);
+        }
+
+        table().frames++;
+    }
+
+    inline void AllocationTracker::setStrict(bool enabled) {
+        strictMode() = enabled;
+    }
+
+    inline void AllocationTracker::writeReport(std::ostream& stream) {
+        std::uint64_t frames = table().frames;
+        stream << "allocations per frame over " << frames << " frames:\n";
+
+        for (const Scope& scope : table().scopes) {
+            if (scope.totalCount == 0) {
+                continue;
+            }
+
+            double divisor = std::max<std::uint64_t>(frames, 1);
+
+            stream << scope.name.load()
+                   << ": " << scope.totalCount / divisor << " allocations"
+                   << " (max " << scope.maxFrameCount << ")"
+                   << ", " << scope.totalBytes / divisor << " bytes\n";
+        }
+    }
+}
+
+/**
+ * `TRACK_ALLOCATIONS("name")` attributes the allocations of the rest of the
+ * enclosing scope to `name`, `ALLOW_ALLOCATIONS()` exempts them from strict
+ * mode, and `END_ALLOCATION_FRAME()` closes a frame. All expand to nothing
+ * unless the build defines
+ * `ARKANOID_ALLOCATION_TRACKING` (meson option `allocation_tracking`).
+ */
+#define ALLOCATION_CONCAT_IMPL(a, b) a##b
+#define ALLOCATION_CONCAT(a, b) ALLOCATION_CONCAT_IMPL(a, b)
+
+#ifdef ARKANOID_ALLOCATION_TRACKING
+    #define TRACK_ALLOCATIONS(name) \
+        ::memory::AllocationScope ALLOCATION_CONCAT(allocationScope, __LINE__)(name)
+    #define ALLOW_ALLOCATIONS() \
+        ::memory::AllowedAllocations ALLOCATION_CONCAT(allowedAllocations, __LINE__)
+    #define END_ALLOCATION_FRAME() ::memory::AllocationTracker::endFrame()
+#else
+    #define TRACK_ALLOCATIONS(name) ((void) 0)
+    #define ALLOW_ALLOCATIONS() ((void) 0)
+    #define END_ALLOCATION_FRAME() ((void) 0)
+#endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace memory {
+    /**
+     * Linear allocator for data that only lives during a single frame.
+     *
+     * Allocations bump a pointer into a preallocated buffer and individual
+     * deallocations are no-ops: all the memory is reclaimed at once by
+     * `reset`. If a frame needs more memory than available, the excess is
+     * taken from the global heap and the buffer is grown on the next
+     * `reset`, so that steady-state frames perform no heap allocations.
+     */
+    class FrameArena : public std::pmr::memory_resource {
+     public:
+        explicit FrameArena(std::size_t initialCapacity = 64 * 1024);
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        /**
+         * Releases all the memory allocated since the last reset. Any
+         * container still using this arena is left dangling.
+         */
+        void reset();
+
+        std::size_t capacity() const;
+        std::size_t used() const;
+
+     private:
+        std::unique_ptr<std::byte[]> buffer;
+        std::size_t bufferCapacity;
+        std::size_t offset = 0;
+        std::vector<std::unique_ptr<std::byte[]>> overflowBlocks;
+        std::size_t overflowBytes = 0;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void*, std::size_t, std::size_t) override { }
+        bool do_is_equal(const std::pmr::memory_resource&) const noexcept override;
+    };
+
+    inline FrameArena::FrameArena(std::size_t initialCapacity)
+     : buffer(std::make_unique<std::byte[]>(initialCapacity)),
+       bufferCapacity(initialCapacity) { }
+
+    inline void FrameArena::reset() {
+        if (overflowBytes > 0) {
+            bufferCapacity = 2 * (bufferCapacity + overflowBytes);
+            buffer = std::make_unique<std::byte[]>(bufferCapacity);
+            overflowBlocks.clear();
+            overflowBytes = 0;
+        }
+
+        offset = 0;
+    }
+
+    inline std::size_t FrameArena::capacity() const {
+        return bufferCapacity;
+    }
+
+    inline std::size_t FrameArena::used() const {
+        return offset + overflowBytes;
+    }
+
+    inline void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+        void* head = buffer.get() + offset;
+        std::size_t space = bufferCapacity - offset;
+
+        if (std::align(alignment, bytes, head, space)) {
+            offset = bufferCapacity - space + bytes;
+            return head;
+        }
+
+        std::size_t blockSize = bytes + alignment;
+        overflowBlocks.push_back(std::make_unique<std::byte[]>(blockSize));
+        overflowBytes += blockSize;
+
+        void* block = overflowBlocks.back().get();
+        return std::align(alignment, bytes, block, blockSize);
+    }
+
+    inline bool FrameArena::do_is_equal(
+        const std::pmr::memory_resource& other
+    ) const noexcept {
+        return this == &other;
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace memory {
+    /**
+     * Read-only memory mapping of a whole file. The pages are loaded
+     * lazily by the OS as they are touched, so reading the contents is
+     * bounded by memory bandwidth rather than by copies through a stream.
+     */
+    class MappedFile {
+     public:
+        /**
+         * Maps the file at `path`. Throws `std::runtime_error` if it
+         * can't be opened or mapped.
+         */
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const std::byte* data() const;
+        std::size_t size() const;
+
+     private:
+        void* address = nullptr;
+        std::size_t length = 0;
+    };
+
+
+    inline MappedFile::MappedFile(const std::string& path) {
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+
+        if (descriptor < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+
+        struct stat status;
+
+        if (::fstat(descriptor, &status) < 0) {
+            ::close(descriptor);
+            throw std::runtime_error("cannot stat " + path);
+        }
+
+        length = status.st_size;
+
+        // Empty files can't be mapped, but are still valid (empty) contents
+        if (length > 0) {
+            address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        }
+
+        ::close(descriptor);
+
+        if (address == MAP_FAILED) {
+            address = nullptr;
+            throw std::runtime_error("cannot map " + path);
+        }
+
+        if (address) {
+            // The contents are read front to back exactly once
+            ::madvise(address, length, MADV_SEQUENTIAL);
+            ::madvise(address, length, MADV_WILLNEED);
+        }
+    }
+
+    inline MappedFile::~MappedFile() {
+        if (address) {
+            ::munmap(address, length);
+        }
+    }
+
+    inline const std::byte* MappedFile::data() const {
+        return static_cast<const std::byte*>(address);
+    }
+
+    inline std::size_t MappedFile::size() const {
+        return length;
+    }
+}
@@ -0,0 +1,46 @@
+#include <cstdlib>
+#include <new>
+#include "AllocationTracker.hpp"
+
+// Replacements of the global allocation functions that report every
+// allocation to the `AllocationTracker`. Only built with the meson option
+// `allocation_tracking`. The nothrow and array variants forward to these.
+
+void* operator new(std::size_t size) {
+    memory::AllocationTracker::recordAllocation(size);
+
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    memory::AllocationTracker::recordAllocation(size);
+
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t roundedSize = (size + align - 1) / align * align;
+
+    if (void* pointer = std::aligned_alloc(align, roundedSize ? roundedSize : align)) {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
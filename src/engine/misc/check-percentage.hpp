@@ -3,11 +3,13 @@
 #include <random>
 
 namespace misc {
-    inline bool checkPercentage(int percentage) {
-        static std::random_device randomDevice;
-        static std::mt19937 gen(randomDevice());
-        static std::uniform_int_distribution<> distribution(1, 100);
+    /**
+     * Returns true with the given probability. The outcome only depends
+     * on the state of `engine`, so that seeded runs are reproducible.
+     */
+    inline bool checkPercentage(std::mt19937& engine, int percentage) {
+        std::uniform_int_distribution<> distribution(1, 100);
 
-        return distribution(gen) <= percentage;
+        return distribution(engine) <= percentage;
     }
 }
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace networking {
+    /**
+     * Connected UNIX domain stream socket exchanging framed messages: a
+     * little-endian uint32 length, then that many bytes.
+     *
+     * Sending blocks until the whole message is written. Receiving doesn't
+     * block by default, and keeps partial messages until the rest arrives.
+     * Once the peer disconnects, the socket is closed and both are no-ops.
+     */
+    class LocalSocket {
+     public:
+        /**
+         * Largest message accepted, so that a corrupt length can't make
+         * the receiver allocate without bounds.
+         */
+        static constexpr std::uint32_t MAX_MESSAGE_SIZE = 1u << 30;
+
+        /**
+         * Creates a socket file at `path`, replacing any stale one, and
+         * waits for a single peer to connect. The file is removed once the
+         * peer is connected. Throws `std::runtime_error` on failure.
+         */
+        static LocalSocket listen(const std::string& path);
+
+        /**
+         * Connects to a socket created by `listen`. Throws
+         * `std::runtime_error` on failure.
+         */
+        static LocalSocket connect(const std::string& path);
+
+        LocalSocket(LocalSocket&&) noexcept;
+        LocalSocket& operator=(LocalSocket&&) noexcept;
+        ~LocalSocket();
+
+        LocalSocket(const LocalSocket&) = delete;
+        LocalSocket& operator=(const LocalSocket&) = delete;
+
+        void send(const std::uint8_t* data, std::size_t size);
+
+        /**
+         * Moves the next complete message into `message`. Returns false if
+         * there is none yet, or if the socket is closed. With `wait`, blocks
+         * until a message arrives or the peer disconnects.
+         */
+        bool receive(std::vector<std::uint8_t>& message, bool wait = false);
+
+        bool isClosed() const;
+
+     private:
+        int descriptor;
+        bool closed = false;
+        std::vector<std::uint8_t> pending;
+        std::size_t pendingStart = 0;
+
+        explicit LocalSocket(int descriptor) : descriptor(descriptor) { }
+
+        bool takeMessage(std::vector<std::uint8_t>& message);
+    };
+
+
+    namespace __detail {
+        inline sockaddr_un socketAddress(const std::string& path) {
+            sockaddr_un address {};
+            address.sun_family = AF_UNIX;
+
+            if (path.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error("socket path too long: " + path);
+            }
+
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            return address;
+        }
+
+        inline int createSocket() {
+            int descriptor = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+            if (descriptor < 0) {
+                throw std::runtime_error(std::string("cannot create socket: ") + std::strerror(errno));
+            }
+
+            return descriptor;
+        }
+    }
+
+    inline LocalSocket LocalSocket::listen(const std::string& path) {
+        sockaddr_un address = __detail::socketAddress(path);
+        int listener = __detail::createSocket();
+
+        ::unlink(path.c_str());
+
+        if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+            || ::listen(listener, 1) < 0) {
+            std::string reason = std::strerror(errno);
+            ::close(listener);
+            throw std::runtime_error("cannot listen on " + path + ": " + reason);
+        }
+
+        int descriptor;
+        do {
+            descriptor = ::accept(listener, nullptr, nullptr);
+        } while (descriptor < 0 && errno == EINTR);
+
+        std::string reason = std::strerror(errno);
+        ::close(listener);
+        ::unlink(path.c_str());
+
+        if (descriptor < 0) {
+            throw std::runtime_error("cannot accept on " + path + ": " + reason);
+        }
+
+        return LocalSocket(descriptor);
+    }
+
+    inline LocalSocket LocalSocket::connect(const std::string& path) {
+        sockaddr_un address = __detail::socketAddress(path);
+        int descriptor = __detail::createSocket();
+
+        if (::connect(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            std::string reason = std::strerror(errno);
+            ::close(descriptor);
+            throw std::runtime_error("cannot connect to " + path + ": " + reason);
+        }
+
+        return LocalSocket(descriptor);
+    }
+
+    inline LocalSocket::LocalSocket(LocalSocket&& other) noexcept
+        : descriptor(other.descriptor),
+          closed(other.closed),
+          pending(std::move(other.pending)),
+          pendingStart(other.pendingStart) {
+        other.descriptor = -1;
+        other.closed = true;
+    }
+
+    inline LocalSocket& LocalSocket::operator=(LocalSocket&& other) noexcept {
+        if (this != &other) {
+            if (descriptor >= 0) {
+                ::close(descriptor);
+            }
+
+            descriptor = other.descriptor;
+            closed = other.closed;
+            pending = std::move(other.pending);
+            pendingStart = other.pendingStart;
+            other.descriptor = -1;
+            other.closed = true;
+        }
+
+        return *this;
+    }
+
+    inline LocalSocket::~LocalSocket() {
+        if (descriptor >= 0) {
+            ::close(descriptor);
+        }
+    }
+
+    inline void LocalSocket::send(const std::uint8_t* data, std::size_t size) {
+        if (closed) {
+            return;
+        }
+
+        if (size > MAX_MESSAGE_SIZE) {
+            throw std::runtime_error("message too large");
+        }
+
+        std::uint8_t length[4];
+        for (std::size_t i = 0; i < 4; i++) {
+            length[i] = static_cast<std::uint8_t>(size >> (8 * i));
+        }
+
+        // Writes the length then the payload, resuming after partial writes
+        const std::uint8_t* parts[] = { length, data };
+        std::size_t sizes[] = { sizeof(length), size };
+
+        for (std::size_t part = 0; part < 2; part++) {
+            std::size_t written = 0;
+
+            while (written < sizes[part]) {
+                // MSG_NOSIGNAL reports a disconnected peer as EPIPE, not SIGPIPE
+                ssize_t count = ::send(
+                    descriptor,
+                    parts[part] + written,
+                    sizes[part] - written,
+                    MSG_NOSIGNAL
+                );
+
+                if (count >= 0) {
+                    written += count;
+                } else if (errno == EPIPE || errno == ECONNRESET) {
+                    closed = true;
+                    return;
+                } else if (errno != EINTR) {
+                    throw std::runtime_error(std::string("cannot send: ") + std::strerror(errno));
+                }
+            }
+        }
+    }
+
+    inline bool LocalSocket::receive(std::vector<std::uint8_t>& message, bool wait) {
+        while (!takeMessage(message)) {
+            if (closed) {
+                return false;
+            }
+
+            std::uint8_t buffer[65536];
+            ssize_t count = ::recv(descriptor, buffer, sizeof(buffer), wait ? 0 : MSG_DONTWAIT);
+
+            if (count > 0) {
+                pending.insert(pending.end(), buffer, buffer + count);
+            } else if (count == 0 || errno == ECONNRESET) {
+                closed = true;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return false;
+            } else if (errno != EINTR) {
+                throw std::runtime_error(std::string("cannot receive: ") + std::strerror(errno));
+            }
+        }
+
+        return true;
+    }
+
+    inline bool LocalSocket::isClosed() const {
+        return closed;
+    }
+
+    inline bool LocalSocket::takeMessage(std::vector<std::uint8_t>& message) {
+        std::size_t available = pending.size() - pendingStart;
+
+        if (available < 4) {
+            return false;
+        }
+
+        const std::uint8_t* start = pending.data() + pendingStart;
+        std::uint32_t size = 0;
+        for (std::size_t i = 0; i < 4; i++) {
+            size |= std::uint32_t(start[i]) << (8 * i);
+        }
+
+        if (size > MAX_MESSAGE_SIZE) {
+            throw std::runtime_error("received message too large");
+        }
+
+        if (available - 4 < size) {
+            return false;
+        }
+
+        message.assign(start + 4, start + 4 + size);
+        pendingStart += 4 + size;
+
+        // Drops consumed bytes once they outweigh the ones still pending
+        if (pendingStart == pending.size()) {
+            pending.clear();
+            pendingStart = 0;
+        } else if (pendingStart > pending.size() / 2) {
+            pending.erase(pending.begin(), pending.begin() + pendingStart);
+            pendingStart = 0;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../memory/AllocationTracker.hpp"
+#include "../threading/SpscRing.hpp"
+
+namespace profiling {
+    using Clock = std::chrono::steady_clock;
+
+    struct Sample {
+        const char* name;
+        std::int64_t start;
+        std::int64_t duration;
+    };
+
+    /**
+     * Samples of a single thread. The owning thread pushes without locking,
+     * and samples that don't fit are dropped rather than blocking it.
+     */
+    struct SampleRing {
+        static constexpr std::size_t CAPACITY = 1 << 16;
+
+        explicit SampleRing(unsigned threadId) : threadId(threadId) { }
+
+        const unsigned threadId;
+        std::atomic<std::size_t> dropped { 0 };
+        threading::SpscRing<Sample, CAPACITY> samples;
+    };
+
+    /**
+     * Summary of the latest durations of a scope, in microseconds.
+     */
+    struct ScopeSummary {
+        std::string name;
+        std::size_t count;
+        double p50;
+        double p99;
+    };
+
+    /**
+     * Collects the samples of `PROFILE_SCOPE`s from all threads.
+     *
+     * Recording only touches the ring of the current thread. The rings are
+     * emptied by `collect`, which should be called about once per frame
+     * from any single thread, and which keeps the latest samples for the
+     * trace export and the latest durations of every scope for summaries.
+     */
+    class Profiler {
+     public:
+        static constexpr std::size_t MAX_TRACE_EVENTS = 1 << 20;
+        static constexpr std::size_t SUMMARY_WINDOW = 1024;
+
+        static Profiler& instance();
+
+        void record(const char* name, Clock::time_point start, Clock::time_point end);
+        void collect();
+
+        /**
+         * Writes the collected samples in the Chrome trace event format,
+         * which can be loaded by chrome://tracing and Perfetto.
+         */
+        void writeChromeTrace(std::ostream&);
+
+        /**
+         * Returns the p50/p99 of the last `SUMMARY_WINDOW` durations of
+         * every scope, sorted by name.
+         */
+        std::vector<ScopeSummary> summarize();
+        void writeSummary(std::ostream&);
+
+        /**
+         * Writes the Chrome trace into a file and the summary into `summary`.
+         */
+        void exportTo(const std::string& tracePath, std::ostream& summary);
+
+     private:
+        struct TraceEvent {
+            Sample sample;
+            unsigned threadId;
+        };
+
+        struct Window {
+            std::vector<std::int64_t> durations;
+            std::size_t next = 0;
+        };
+
+        const Clock::time_point epoch = Clock::now();
+
+        std::mutex ringsMutex;
+        std::vector<std::unique_ptr<SampleRing>> rings;
+
+        std::mutex collectMutex;
+        std::vector<TraceEvent> traceEvents;
+        std::size_t nextTraceEvent = 0;
+        std::map<std::string, Window, std::less<>> windows;
+
+        SampleRing& localRing();
+    };
+
+    /**
+     * Records the time between its construction and destruction.
+     */
+    class ScopedTimer {
+     public:
+        // The profiler is fetched first so that its epoch precedes `start`
+        explicit ScopedTimer(const char* name)
+         : profiler(Profiler::instance()), name(name), start(Clock::now()) { }
+
+        ~ScopedTimer() {
+            profiler.record(name, start, Clock::now());
+        }
+
+     private:
+        Profiler& profiler;
+        const char* name;
+        Clock::time_point start;
+    };
+
+    inline Profiler& Profiler::instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    inline void Profiler::record(
+        const char* name,
+        Clock::time_point start,
+        Clock::time_point end
+    ) {
+        using std::chrono::nanoseconds;
+        using std::chrono::duration_cast;
+
+        SampleRing& ring = localRing();
+
+        bool pushed = ring.samples.push(Sample {
+            name,
+            duration_cast<nanoseconds>(start - epoch).count(),
+            duration_cast<nanoseconds>(end - start).count()
+        });
+
+        if (!pushed) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    inline void Profiler::collect() {
+        std::lock_guard<std::mutex> collectLock(collectMutex);
+        std::lock_guard<std::mutex> ringsLock(ringsMutex);
+
+        for (auto& ring : rings) {
+            ring->samples.drain([this, &ring](const Sample& sample) {
+                TraceEvent event { sample, ring->threadId };
+
+                if (traceEvents.size() < MAX_TRACE_EVENTS) {
+                    traceEvents.push_back(event);
+                } else {
+                    traceEvents[nextTraceEvent] = event;
+                    nextTraceEvent = (nextTraceEvent + 1) % MAX_TRACE_EVENTS;
+                }
+
+                auto it = windows.find(std::string_view(sample.name));
+                if (it == windows.end()) {
+                    it = windows.emplace(sample.name, Window()).first;
+                }
+
+                Window& window = it->second;
+
+                if (window.durations.size() < SUMMARY_WINDOW) {
+                    window.durations.push_back(sample.duration);
+                } else {
+                    window.durations[window.next] = sample.duration;
+                    window.next = (window.next + 1) % SUMMARY_WINDOW;
+                }
+            });
+        }
+    }
+
+    inline void Profiler::writeChromeTrace(std::ostream& stream) {
+        collect();
+        std::lock_guard<std::mutex> lock(collectMutex);
+
+        stream << "{\"traceEvents\":[";
+
+        // Oldest first, in case the events wrapped around
+        for (std::size_t i = 0; i < traceEvents.size(); i++) {
+            const TraceEvent& event = traceEvents[(nextTraceEvent + i) % traceEvents.size()];
+
+            stream << (i > 0 ? ",\n" : "\n")
+                   << "{\"name\":\"" << event.sample.name << "\""
+                   << ",\"ph\":\"X\",\"pid\":0"
+                   << ",\"tid\":" << event.threadId
+                   << ",\"ts\":" << event.sample.start / 1000.0
+                   << ",\"dur\":" << event.sample.duration / 1000.0 << "}";
+        }
+
+        stream << "\n]}\n";
+    }
+
+    inline std::vector<ScopeSummary> Profiler::summarize() {
+        collect();
+        std::lock_guard<std::mutex> lock(collectMutex);
+
+        std::vector<ScopeSummary> result;
+
+        for (const auto& [name, window] : windows) {
+            std::vector<std::int64_t> durations = window.durations;
+            std::sort(durations.begin(), durations.end());
+
+            auto percentile = [&durations](double p) {
+                return durations[(durations.size() - 1) * p] / 1000.0;
+            };
+
+            result.push_back({ name, durations.size(), percentile(0.5), percentile(0.99) });
+        }
+
+        return result;
+    }
+
+    inline void Profiler::writeSummary(std::ostream& stream) {
+        for (const ScopeSummary& summary : summarize()) {
+            stream << summary.name
+                   << ": p50 " << summary.p50 << "us"
+                   << ", p99 " << summary.p99 << "us"
+                   << " (" << summary.count << " samples)\n";
+        }
+
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (auto& ring : rings) {
+            if (ring->dropped > 0) {
+                stream << "thread " << ring->threadId << ": "
+                       << ring->dropped << " samples dropped\n";
+            }
+        }
+    }
+
+    inline void Profiler::exportTo(const std::string& tracePath, std::ostream& summary) {
+        std::ofstream file(tracePath);
+        writeChromeTrace(file);
+        writeSummary(summary);
+    }
+
+    inline SampleRing& Profiler::localRing() {
+        // Rings are never destroyed before the profiler, so that samples of
+        // threads that already finished can still be collected
+        thread_local SampleRing* ring = nullptr;
+
+        if (!ring) {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.push_back(std::make_unique<SampleRing>(rings.size()));
+            ring = rings.back().get();
+        }
+
+        return *ring;
+    }
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+/**
+ * `PROFILE_SCOPE("name")` times the rest of the enclosing scope, where
+ * `name` must be a string literal, and `PROFILE_COLLECT()` drains the
+ * samples of all threads. Both expand to nothing unless the build defines
+ * `ARKANOID_PROFILING` (meson option `profiling`).
+ */
+#ifdef ARKANOID_PROFILING
+    #define PROFILE_SCOPE(name) \
+        ::profiling::ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(name)
+    #define PROFILE_COLLECT() ::profiling::Profiler::instance().collect()
+#else
+    #define PROFILE_SCOPE(name) ((void) 0)
+    #define PROFILE_COLLECT() ((void) 0)
+#endif
+
+/**
+ * `PROFILE_SYSTEM("name")` marks the entry point of a system: it is timed
+ * like a `PROFILE_SCOPE`, and the allocations made until it returns are
+ * attributed to it (see `TRACK_ALLOCATIONS`).
+ */
+#define PROFILE_SYSTEM(name) PROFILE_SCOPE(name); TRACK_ALLOCATIONS(name)
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "CommandList.hpp"
+#include "VertexBatch.hpp"
+
+namespace rendering {
+    /**
+     * Consumes the command list of a frame, e.g by drawing it to a window.
+     */
+    class Backend {
+     public:
+        virtual ~Backend() = default;
+
+        virtual DrawStats draw(const CommandList&) = 0;
+    };
+}
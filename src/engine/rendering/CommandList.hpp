@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+namespace rendering {
+    enum class Shape : std::uint8_t {
+        Circle,
+        Rectangle,
+    };
+
+    /**
+     * Draws a shape centered at (x, y). Circles use `width` as diameter.
+     * Outlines are drawn inwards, within the extent of the shape.
+     */
+    struct DrawCommand {
+        Shape shape;
+        float x;
+        float y;
+        float width;
+        float height;
+        sf::Color fillColor;
+        sf::Color borderColor;
+        float borderThickness;
+    };
+
+    using Commands = std::vector<DrawCommand>;
+
+    /**
+     * A group of commands that rarely changes. Backends may cache whatever
+     * they derive from `commands` for as long as `revision` doesn't change.
+     */
+    struct StaticBatch {
+        std::uint64_t id;
+        std::uint64_t revision;
+        std::shared_ptr<const Commands> commands;
+    };
+
+    /**
+     * Everything that has to be drawn in a frame. Static batches are drawn
+     * first, in order, and the dynamic commands on top of them.
+     */
+    struct CommandList {
+        std::vector<StaticBatch> staticBatches;
+        Commands dynamicCommands;
+
+        void clear() {
+            staticBatches.clear();
+            dynamicCommands.clear();
+        }
+    };
+
+    /**
+     * Returns a revision number that is unique within the process, so that
+     * a backend never confuses two versions of a static batch.
+     */
+    inline std::uint64_t nextRevision() {
+        static std::atomic<std::uint64_t> counter { 0 };
+        return ++counter;
+    }
+
+    inline DrawCommand circle(
+        float x,
+        float y,
+        float radius,
+        sf::Color fillColor,
+        sf::Color borderColor,
+        float borderThickness
+    ) {
+        return DrawCommand {
+            Shape::Circle,
+            x,
+            y,
+            2 * radius,
+            2 * radius,
+            fillColor,
+            borderColor,
+            borderThickness
+        };
+    }
+
+    inline DrawCommand rectangle(
+        float x,
+        float y,
+        float width,
+        float height,
+        sf::Color fillColor,
+        sf::Color borderColor,
+        float borderThickness
+    ) {
+        return DrawCommand {
+            Shape::Rectangle,
+            x,
+            y,
+            width,
+            height,
+            fillColor,
+            borderColor,
+            borderThickness
+        };
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+namespace rendering {
+    /**
+     * Tessellated circle centered at the origin, as two triangle lists: the
+     * full disc, covered by the border color, and the inner disc, covered
+     * by the fill color.
+     */
+    struct CircleMesh {
+        std::vector<sf::Vector2f> border;
+        std::vector<sf::Vector2f> fill;
+    };
+
+    /**
+     * Stores circle meshes by (radius, border thickness, point count), so
+     * that every circle is tessellated once and drawing it only takes
+     * a translation of the cached vertices.
+     */
+    class GeometryCache {
+     public:
+        static constexpr unsigned DEFAULT_POINT_COUNT = 30;
+
+        const CircleMesh& circle(
+            float radius,
+            float borderThickness,
+            unsigned pointCount = DEFAULT_POINT_COUNT
+        );
+
+        std::size_t size() const;
+
+     private:
+        std::map<std::tuple<float, float, unsigned>, CircleMesh> circles;
+
+        static void tessellateDisc(float radius, unsigned pointCount, std::vector<sf::Vector2f>&);
+    };
+
+    inline const CircleMesh& GeometryCache::circle(
+        float radius,
+        float borderThickness,
+        unsigned pointCount
+    ) {
+        auto [it, inserted] = circles.try_emplace({ radius, borderThickness, pointCount });
+        CircleMesh& mesh = it->second;
+
+        if (inserted) {
+            if (borderThickness > 0) {
+                tessellateDisc(radius, pointCount, mesh.border);
+            }
+
+            tessellateDisc(radius - borderThickness, pointCount, mesh.fill);
+        }
+
+        return mesh;
+    }
+
+    inline std::size_t GeometryCache::size() const {
+        return circles.size();
+    }
+
+    inline void GeometryCache::tessellateDisc(
+        float radius,
+        unsigned pointCount,
+        std::vector<sf::Vector2f>& vertices
+    ) {
+        constexpr float PI = 3.14159265358979f;
+        const float step = 2 * PI / pointCount;
+
+        sf::Vector2f center { 0, 0 };
+        sf::Vector2f previous { radius, 0 };
+        vertices.reserve(3 * pointCount);
+
+        for (unsigned i = 1; i <= pointCount; i++) {
+            sf::Vector2f current {
+                radius * std::cos(i * step),
+                radius * std::sin(i * step)
+            };
+
+            vertices.push_back(center);
+            vertices.push_back(previous);
+            vertices.push_back(current);
+            previous = current;
+        }
+    }
+}
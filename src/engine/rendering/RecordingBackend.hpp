@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include "Backend.hpp"
+#include "GeometryCache.hpp"
+#include "VertexBatch.hpp"
+
+namespace rendering {
+    /**
+     * Backend that draws nothing, allowing the render path to run without a
+     * display. It counts the primitives it receives and, if given a stream,
+     * serializes every frame as text, one primitive per line, so that frames
+     * can be diffed.
+     *
+     * The returned draw stats are the ones `SfmlBackend` would report: every
+     * batch is converted to the same vertices, one draw call per non-empty
+     * batch, but nothing is cached or drawn.
+     */
+    class RecordingBackend : public Backend {
+     public:
+        struct Counters {
+            std::size_t frames = 0;
+            std::size_t staticBatches = 0;
+            std::size_t circles = 0;
+            std::size_t rectangles = 0;
+        };
+
+        explicit RecordingBackend(std::ostream* output = nullptr) : output(output) { }
+
+        DrawStats draw(const CommandList&) override;
+
+        const Counters& lastFrame() const { return frameCounters; }
+        const Counters& total() const { return totalCounters; }
+
+     private:
+        std::ostream* output;
+        Counters frameCounters;
+        Counters totalCounters;
+        VertexBatch vertices;
+        GeometryCache geometry;
+
+        void record(const DrawCommand&);
+        void count(DrawStats&) const;
+    };
+
+    inline DrawStats RecordingBackend::draw(const CommandList& commandList) {
+        frameCounters = Counters { };
+        frameCounters.frames = 1;
+        frameCounters.staticBatches = commandList.staticBatches.size();
+
+        if (output) {
+            *output << "frame " << totalCounters.frames << '\n';
+        }
+
+        DrawStats stats;
+
+        for (const StaticBatch& batch : commandList.staticBatches) {
+            vertices.clear();
+
+            for (const DrawCommand& command : *batch.commands) {
+                record(command);
+                vertices.add(command, geometry);
+            }
+
+            count(stats);
+        }
+
+        vertices.clear();
+
+        for (const DrawCommand& command : commandList.dynamicCommands) {
+            record(command);
+            vertices.add(command, geometry);
+        }
+
+        count(stats);
+
+        totalCounters.frames += frameCounters.frames;
+        totalCounters.staticBatches += frameCounters.staticBatches;
+        totalCounters.circles += frameCounters.circles;
+        totalCounters.rectangles += frameCounters.rectangles;
+
+        return stats;
+    }
+
+    inline void RecordingBackend::count(DrawStats& stats) const {
+        if (vertices.vertexCount() > 0) {
+            stats.drawCalls++;
+            stats.vertices += vertices.vertexCount();
+        }
+    }
+
+    inline void RecordingBackend::record(const DrawCommand& command) {
+        bool isCircle = command.shape == Shape::Circle;
+        (isCircle ? frameCounters.circles : frameCounters.rectangles)++;
+
+        if (!output) {
+            return;
+        }
+
+        std::ostream& out = *output;
+        auto flags = out.flags();
+
+        out << (isCircle ? 'C' : 'R') << ' '
+            << command.x << ' ' << command.y << ' '
+            << command.width << ' ' << command.height << ' '
+            << std::hex << std::setfill('0')
+            << std::setw(8) << command.fillColor.toInteger() << ' '
+            << std::setw(8) << command.borderColor.toInteger() << ' '
+            << std::dec << command.borderThickness << '\n';
+
+        out.flags(flags);
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <unordered_map>
+#include <SFML/Graphics.hpp>
+#include "../profiling/Profiler.hpp"
+#include "Backend.hpp"
+#include "GeometryCache.hpp"
+#include "VertexBatch.hpp"
+
+namespace rendering {
+    /**
+     * Draws command lists to an SFML render target. Static batches are
+     * converted to vertices once per revision and kept in vertex arrays,
+     * while dynamic commands are converted every frame into a single batch.
+     * Circle meshes come from a cache shared by all of them.
+     */
+    class SfmlBackend : public Backend {
+     public:
+        explicit SfmlBackend(sf::RenderTarget& target) : target(target) { }
+
+        DrawStats draw(const CommandList&) override;
+
+     private:
+        struct CachedBatch {
+            std::uint64_t revision;
+            VertexBatch vertices;
+            bool used;
+        };
+
+        sf::RenderTarget& target;
+        std::unordered_map<std::uint64_t, CachedBatch> cache;
+        VertexBatch dynamicVertices;
+        GeometryCache geometry;
+    };
+
+    inline DrawStats SfmlBackend::draw(const CommandList& commandList) {
+        PROFILE_SCOPE("SfmlBackend::draw");
+
+        DrawStats stats;
+
+        for (auto& [id, cachedBatch] : cache) {
+            cachedBatch.used = false;
+        }
+
+        for (const StaticBatch& batch : commandList.staticBatches) {
+            auto [it, inserted] = cache.try_emplace(batch.id);
+            CachedBatch& cachedBatch = it->second;
+
+            if (inserted || cachedBatch.revision != batch.revision) {
+                cachedBatch.revision = batch.revision;
+                cachedBatch.vertices.clear();
+
+                for (const DrawCommand& command : *batch.commands) {
+                    cachedBatch.vertices.add(command, geometry);
+                }
+            }
+
+            cachedBatch.used = true;
+            cachedBatch.vertices.draw(target, stats);
+        }
+
+        // Batches that weren't submitted this frame are gone for good
+        auto it = cache.begin();
+        while (it != cache.end()) {
+            if (it->second.used) {
+                ++it;
+            } else {
+                it = cache.erase(it);
+            }
+        }
+
+        dynamicVertices.clear();
+
+        for (const DrawCommand& command : commandList.dynamicCommands) {
+            dynamicVertices.add(command, geometry);
+        }
+
+        dynamicVertices.draw(target, stats);
+        return stats;
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include "CommandList.hpp"
+
+namespace rendering {
+    /**
+     * Double buffer of command lists that lets the simulation of a frame
+     * overlap with the rendering of the previous one.
+     *
+     * The simulation thread extracts into `back()` and then `publish`es it,
+     * which waits until the render thread is done with the previous
+     * snapshot. The render thread `consume`s snapshots as they are
+     * published.
+     */
+    class SnapshotBuffer {
+     public:
+        /**
+         * The snapshot being written by the simulation thread.
+         */
+        CommandList& back();
+
+        /**
+         * Hands the back buffer over to the render thread, blocking while it
+         * is still drawing the previous snapshot.
+         */
+        void publish();
+
+        /**
+         * Same as `publish`, but gives up after `timeout` if the render
+         * thread is still drawing. Returns whether the back buffer was
+         * handed over.
+         */
+        template<typename Rep, typename Period>
+        bool publishFor(const std::chrono::duration<Rep, Period>& timeout);
+
+        /**
+         * Blocks until a snapshot is published and calls `fn` with it.
+         * Returns false, without calling `fn`, once the buffer is closed.
+         */
+        template<typename F>
+        bool consume(F fn);
+
+        /**
+         * Wakes up and stops both threads.
+         */
+        void close();
+
+     private:
+        CommandList buffers[2];
+        unsigned backIndex = 0;
+        bool frontReady = false;
+        bool closed = false;
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+
+    inline CommandList& SnapshotBuffer::back() {
+        return buffers[backIndex];
+    }
+
+    inline void SnapshotBuffer::publish() {
+        std::unique_lock lock(mutex);
+        condition.wait(lock, [this] { return !frontReady || closed; });
+
+        backIndex ^= 1;
+        frontReady = true;
+        condition.notify_all();
+    }
+
+    template<typename Rep, typename Period>
+    inline bool SnapshotBuffer::publishFor(const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock lock(mutex);
+
+        if (!condition.wait_for(lock, timeout, [this] { return !frontReady || closed; })) {
+            return false;
+        }
+
+        backIndex ^= 1;
+        frontReady = true;
+        condition.notify_all();
+        return true;
+    }
+
+    template<typename F>
+    inline bool SnapshotBuffer::consume(F fn) {
+        std::unique_lock lock(mutex);
+        condition.wait(lock, [this] { return frontReady || closed; });
+
+        if (closed) {
+            return false;
+        }
+
+        const CommandList& front = buffers[backIndex ^ 1];
+        lock.unlock();
+        fn(front);
+        lock.lock();
+
+        frontReady = false;
+        condition.notify_all();
+        return true;
+    }
+
+    inline void SnapshotBuffer::close() {
+        std::lock_guard lock(mutex);
+        closed = true;
+        condition.notify_all();
+    }
+}
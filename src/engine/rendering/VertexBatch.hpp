@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <SFML/Graphics.hpp>
+#include "CommandList.hpp"
+#include "GeometryCache.hpp"
+
+namespace rendering {
+    /**
+     * Counters of the work submitted to the GPU in a frame.
+     */
+    struct DrawStats {
+        unsigned drawCalls = 0;
+        std::size_t vertices = 0;
+    };
+
+    /**
+     * Accumulates the fill and outline geometry of many shapes into a single
+     * triangle list, so that all of them can be drawn with one draw call.
+     *
+     * Outlines are drawn inwards: the full extent of a shape is covered by
+     * its border color, and its fill is drawn on top, inset by the border
+     * thickness. Circles are taken pre-tessellated from a `GeometryCache`.
+     */
+    class VertexBatch {
+     public:
+        void addRectangle(
+            float left,
+            float top,
+            float width,
+            float height,
+            sf::Color fillColor,
+            sf::Color borderColor,
+            float borderThickness
+        );
+
+        void addCircle(
+            float centerX,
+            float centerY,
+            const CircleMesh&,
+            sf::Color fillColor,
+            sf::Color borderColor
+        );
+
+        void add(const DrawCommand&, GeometryCache&);
+        void clear();
+        std::size_t vertexCount() const;
+        void draw(sf::RenderTarget&, DrawStats&) const;
+
+     private:
+        sf::VertexArray vertices { sf::Triangles };
+
+        void appendQuad(float left, float top, float width, float height, sf::Color);
+        void appendMesh(float x, float y, const std::vector<sf::Vector2f>&, sf::Color);
+    };
+
+    inline void VertexBatch::addRectangle(
+        float left,
+        float top,
+        float width,
+        float height,
+        sf::Color fillColor,
+        sf::Color borderColor,
+        float borderThickness
+    ) {
+        if (borderThickness > 0) {
+            appendQuad(left, top, width, height, borderColor);
+        }
+
+        appendQuad(
+            left + borderThickness,
+            top + borderThickness,
+            width - 2 * borderThickness,
+            height - 2 * borderThickness,
+            fillColor
+        );
+    }
+
+    inline void VertexBatch::addCircle(
+        float centerX,
+        float centerY,
+        const CircleMesh& mesh,
+        sf::Color fillColor,
+        sf::Color borderColor
+    ) {
+        appendMesh(centerX, centerY, mesh.border, borderColor);
+        appendMesh(centerX, centerY, mesh.fill, fillColor);
+    }
+
+    inline void VertexBatch::add(const DrawCommand& command, GeometryCache& geometry) {
+        if (command.shape == Shape::Circle) {
+            addCircle(
+                command.x,
+                command.y,
+                geometry.circle(command.width / 2, command.borderThickness),
+                command.fillColor,
+                command.borderColor
+            );
+        } else {
+            addRectangle(
+                command.x - command.width / 2,
+                command.y - command.height / 2,
+                command.width,
+                command.height,
+                command.fillColor,
+                command.borderColor,
+                command.borderThickness
+            );
+        }
+    }
+
+    inline void VertexBatch::clear() {
+        vertices.clear();
+    }
+
+    inline std::size_t VertexBatch::vertexCount() const {
+        return vertices.getVertexCount();
+    }
+
+    inline void VertexBatch::draw(sf::RenderTarget& target, DrawStats& stats) const {
+        if (vertices.getVertexCount() == 0) {
+            return;
+        }
+
+        target.draw(vertices);
+        stats.drawCalls++;
+        stats.vertices += vertices.getVertexCount();
+    }
+
+    inline void VertexBatch::appendQuad(
+        float left,
+        float top,
+        float width,
+        float height,
+        sf::Color color
+    ) {
+        sf::Vector2f topLeft { left, top };
+        sf::Vector2f topRight { left + width, top };
+        sf::Vector2f bottomLeft { left, top + height };
+        sf::Vector2f bottomRight { left + width, top + height };
+
+        vertices.append(sf::Vertex(topLeft, color));
+        vertices.append(sf::Vertex(topRight, color));
+        vertices.append(sf::Vertex(bottomRight, color));
+        vertices.append(sf::Vertex(topLeft, color));
+        vertices.append(sf::Vertex(bottomRight, color));
+        vertices.append(sf::Vertex(bottomLeft, color));
+    }
+
+    inline void VertexBatch::appendMesh(
+        float x,
+        float y,
+        const std::vector<sf::Vector2f>& mesh,
+        sf::Color color
+    ) {
+        for (const sf::Vector2f& vertex : mesh) {
+            vertices.append(sf::Vertex({ x + vertex.x, y + vertex.y }, color));
+        }
+    }
+}
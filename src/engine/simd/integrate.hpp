@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ARKANOID_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace simd {
+    enum class InstructionSet {
+        Scalar,
+        SSE,
+        AVX2,
+    };
+
+    /**
+     * The widest instruction set that the CPU supports, detected on the
+     * first call. Without x86 SIMD, only the scalar path exists.
+     */
+    InstructionSet bestInstructionSet();
+
+    /**
+     * Advances `count` points by their velocity over `elapsedTime`, as
+     * `x[i] += vx[i] * elapsedTime` (and the same for y), over separate
+     * arrays of each coordinate. The arrays don't need to be aligned.
+     *
+     * Every path rounds the product then the sum, so they all give the same
+     * results as the scalar code and replays don't depend on the CPU. This
+     * holds as long as the build doesn't allow contracting them into fused
+     * multiply-adds, e.g with `-march=native`.
+     */
+    void integrate(
+        float* x,
+        float* y,
+        const float* vx,
+        const float* vy,
+        std::size_t count,
+        float elapsedTime
+    );
+
+    /**
+     * Same as `integrate`, with the given instruction set rather than the
+     * best one, e.g to compare them. It must be supported by the CPU.
+     */
+    void integrate(
+        InstructionSet,
+        float* x,
+        float* y,
+        const float* vx,
+        const float* vy,
+        std::size_t count,
+        float elapsedTime
+    );
+
+
+    namespace __detail {
+        inline void integrateScalar(
+            float* values,
+            const float* velocities,
+            std::size_t begin,
+            std::size_t count,
+            float elapsedTime
+        ) {
+            for (std::size_t i = begin; i < count; i++) {
+                values[i] += velocities[i] * elapsedTime;
+            }
+        }
+
+#ifdef ARKANOID_SIMD_X86
+        // SSE2 is part of x86-64, so this path needs no detection there
+        __attribute__((target("sse2")))
+        inline void integrateSse(
+            float* values,
+            const float* velocities,
+            std::size_t count,
+            float elapsedTime
+        ) {
+            __m128 time = _mm_set1_ps(elapsedTime);
+            std::size_t i = 0;
+
+            for (; i + 4 <= count; i += 4) {
+                __m128 step = _mm_mul_ps(_mm_loadu_ps(velocities + i), time);
+                _mm_storeu_ps(values + i, _mm_add_ps(_mm_loadu_ps(values + i), step));
+            }
+
+            integrateScalar(values, velocities, i, count, elapsedTime);
+        }
+
+        __attribute__((target("avx2")))
+        inline void integrateAvx2(
+            float* values,
+            const float* velocities,
+            std::size_t count,
+            float elapsedTime
+        ) {
+            __m256 time = _mm256_set1_ps(elapsedTime);
+            std::size_t i = 0;
+
+            for (; i + 8 <= count; i += 8) {
+                __m256 step = _mm256_mul_ps(_mm256_loadu_ps(velocities + i), time);
+                _mm256_storeu_ps(values + i, _mm256_add_ps(_mm256_loadu_ps(values + i), step));
+            }
+
+            integrateScalar(values, velocities, i, count, elapsedTime);
+        }
+#endif
+
+        inline void integrateArray(
+            InstructionSet instructionSet,
+            float* values,
+            const float* velocities,
+            std::size_t count,
+            float elapsedTime
+        ) {
+#ifdef ARKANOID_SIMD_X86
+            switch (instructionSet) {
+                case InstructionSet::AVX2:
+                    return integrateAvx2(values, velocities, count, elapsedTime);
+                case InstructionSet::SSE:
+                    return integrateSse(values, velocities, count, elapsedTime);
+                case InstructionSet::Scalar:
+                    break;
+            }
+#endif
+
+            integrateScalar(values, velocities, 0, count, elapsedTime);
+        }
+    }
+
+    inline InstructionSet bestInstructionSet() {
+#ifdef ARKANOID_SIMD_X86
+        static const InstructionSet best = [] {
+            if (__builtin_cpu_supports("avx2")) {
+                return InstructionSet::AVX2;
+            }
+
+            return __builtin_cpu_supports("sse2") ? InstructionSet::SSE : InstructionSet::Scalar;
+        }();
+
+        return best;
+#else
+        return InstructionSet::Scalar;
+#endif
+    }
+
+    inline void integrate(
+        float* x,
+        float* y,
+        const float* vx,
+        const float* vy,
+        std::size_t count,
+        float elapsedTime
+    ) {
+        integrate(bestInstructionSet(), x, y, vx, vy, count, elapsedTime);
+    }
+
+    inline void integrate(
+        InstructionSet instructionSet,
+        float* x,
+        float* y,
+        const float* vx,
+        const float* vy,
+        std::size_t count,
+        float elapsedTime
+    ) {
+        __detail::integrateArray(instructionSet, x, vx, count, elapsedTime);
+        __detail::integrateArray(instructionSet, y, vy, count, elapsedTime);
+    }
+}
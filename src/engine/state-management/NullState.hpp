@@ -6,6 +6,6 @@ namespace state {
     class NullState : public State {
      public:
         virtual void update(const sf::Time& elapsedTime) override { }
-        virtual void render(sf::RenderWindow& window) override { }
+        virtual void render(rendering::CommandList& commandList, float interpolation) override { }
     };
 }
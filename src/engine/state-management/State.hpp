@@ -1,6 +1,7 @@
 #pragma once
 
-#include <SFML/Graphics.hpp>
+#include <SFML/System.hpp>
+#include "../rendering/CommandList.hpp"
 
 namespace state {
     class State {
@@ -10,6 +11,11 @@ namespace state {
         virtual void onEnter() { }
         virtual void onExit() { }
         virtual void update(const sf::Time& elapsedTime) = 0;
-        virtual void render(sf::RenderWindow& window) = 0;
+        /**
+         * Extracts the render commands of the state. `interpolation` is how
+         * far, in the [0, 1] range, the frame is between the previous tick
+         * and the current one.
+         */
+        virtual void render(rendering::CommandList& commandList, float interpolation) = 0;
     };
 }
@@ -4,6 +4,7 @@
 #include <stack>
 #include <string>
 #include <unordered_map>
+#include "../memory/AllocationTracker.hpp"
 #include "NullState.hpp"
 #include "State.hpp"
 
@@ -51,12 +52,17 @@ namespace state {
     }
 
     inline void StateMachine::pushState(const std::string& stateName) {
+        // Entering a state, e.g swapping a level in, isn't a steady-state tick
+        ALLOW_ALLOCATIONS();
+
         states.top()->onExit();
         states.push(registeredStates.at(stateName).get());
         states.top()->onEnter();
     }
 
     inline void StateMachine::popState() {
+        ALLOW_ALLOCATIONS();
+
         if (states.size() > 1) {
             states.top()->onExit();
             states.pop();
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace threading {
+    /**
+     * Bounded single-producer, single-consumer queue. Neither side ever
+     * blocks or allocates: `push` fails when the ring is full, and `drain`
+     * only consumes what was published before it started.
+     */
+    template<typename T, std::size_t CAPACITY>
+    class SpscRing {
+     public:
+        /**
+         * Must only be called by the producer thread. Returns false,
+         * dropping the value, if the ring is full.
+         */
+        bool push(const T&);
+
+        /**
+         * Must only be called by the consumer thread. Calls `fn(value)`
+         * for every value in the ring, oldest first.
+         */
+        template<typename F>
+        void drain(F fn);
+
+     private:
+        std::array<T, CAPACITY> values;
+        std::atomic<std::size_t> head { 0 };
+        std::atomic<std::size_t> tail { 0 };
+    };
+
+    template<typename T, std::size_t CAPACITY>
+    inline bool SpscRing<T, CAPACITY>::push(const T& value) {
+        std::size_t currentHead = head.load(std::memory_order_relaxed);
+
+        if (currentHead - tail.load(std::memory_order_acquire) == CAPACITY) {
+            return false;
+        }
+
+        values[currentHead % CAPACITY] = value;
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    template<typename T, std::size_t CAPACITY>
+    template<typename F>
+    inline void SpscRing<T, CAPACITY>::drain(F fn) {
+        std::size_t currentTail = tail.load(std::memory_order_relaxed);
+        std::size_t currentHead = head.load(std::memory_order_acquire);
+
+        for (; currentTail != currentHead; currentTail++) {
+            fn(values[currentTail % CAPACITY]);
+        }
+
+        tail.store(currentTail, std::memory_order_release);
+    }
+}
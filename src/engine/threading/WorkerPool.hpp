@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace threading {
+    /**
+     * A fixed set of threads that run the iterations of `parallelFor`.
+     *
+     * Iterations are handed out one at a time through an atomic counter, so
+     * slow iterations don't stall a whole chunk. The calling thread takes
+     * part in the work too, so a pool of N threads uses N + 1 cores.
+     */
+    class WorkerPool {
+     public:
+        explicit WorkerPool(unsigned threadCount);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        /**
+         * Calls `fn(i)` for every i in [0, count), spread across the
+         * threads of the pool. Blocks until all the calls are done.
+         *
+         * Iterations run concurrently, so they must not share mutable state.
+         */
+        void parallelFor(std::size_t count, const std::function<void(std::size_t)>& fn);
+
+        unsigned threadCount() const;
+
+     private:
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        std::condition_variable done;
+        const std::function<void(std::size_t)>* task = nullptr;
+        std::size_t taskCount = 0;
+        std::atomic<std::size_t> nextIndex { 0 };
+        unsigned busyThreads = 0;
+        std::uint64_t generation = 0;
+        bool stopping = false;
+
+        void work();
+        void runTasks();
+    };
+
+    inline WorkerPool::WorkerPool(unsigned threadCount) {
+        threads.reserve(threadCount);
+
+        for (unsigned i = 0; i < threadCount; i++) {
+            threads.emplace_back([this] { work(); });
+        }
+    }
+
+    inline WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wakeUp.notify_all();
+
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    inline void WorkerPool::parallelFor(
+        std::size_t count,
+        const std::function<void(std::size_t)>& fn
+    ) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &fn;
+            taskCount = count;
+            nextIndex = 0;
+            busyThreads = threads.size();
+            generation++;
+        }
+
+        wakeUp.notify_all();
+        runTasks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busyThreads == 0; });
+        task = nullptr;
+    }
+
+    inline unsigned WorkerPool::threadCount() const {
+        return threads.size();
+    }
+
+    inline void WorkerPool::work() {
+        std::uint64_t lastGeneration = 0;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock, [this, lastGeneration] {
+                    return stopping || generation != lastGeneration;
+                });
+
+                if (stopping) {
+                    return;
+                }
+
+                lastGeneration = generation;
+            }
+
+            runTasks();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyThreads == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+    inline void WorkerPool::runTasks() {
+        std::size_t index;
+
+        while ((index = nextIndex++) < taskCount) {
+            (*task)(index);
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <SFML/System.hpp>
+
+namespace timing {
+    /**
+     * Turns variable frame times into a whole number of fixed-size ticks.
+     *
+     * The time that doesn't fill a whole tick is carried over to the next
+     * frame, and its ratio to the tick duration is exposed as `alpha` so that
+     * rendering can interpolate between the last two ticks. If a frame takes
+     * so long that more than `maxCatchUpTicks` would be needed, the excess
+     * time is dropped instead of making the simulation spiral behind.
+     */
+    class FixedTimestep {
+     public:
+        FixedTimestep(unsigned ticksPerSecond, unsigned maxCatchUpTicks);
+
+        /**
+         * Adds a frame time and calls `tickFn(tickDuration)` for every
+         * whole tick that fits in the accumulated time. Returns the number
+         * of ticks that were run.
+         */
+        template<typename F>
+        unsigned advance(const sf::Time& elapsedTime, F tickFn);
+
+        const sf::Time& tickDuration() const;
+        float alpha() const;
+
+     private:
+        sf::Time tick;
+        unsigned maxCatchUpTicks;
+        sf::Time accumulator = sf::Time::Zero;
+    };
+
+    inline FixedTimestep::FixedTimestep(unsigned ticksPerSecond, unsigned maxCatchUpTicks)
+     : tick(sf::microseconds(1000000 / ticksPerSecond)),
+       maxCatchUpTicks(maxCatchUpTicks) { }
+
+    template<typename F>
+    inline unsigned FixedTimestep::advance(const sf::Time& elapsedTime, F tickFn) {
+        accumulator += elapsedTime;
+        unsigned ticks = 0;
+
+        while (accumulator >= tick && ticks < maxCatchUpTicks) {
+            tickFn(tick);
+            accumulator -= tick;
+            ticks++;
+        }
+
+        if (accumulator >= tick) {
+            accumulator = sf::microseconds(accumulator.asMicroseconds() % tick.asMicroseconds());
+        }
+
+        return ticks;
+    }
+
+    inline const sf::Time& FixedTimestep::tickDuration() const {
+        return tick;
+    }
+
+    inline float FixedTimestep::alpha() const {
+        return static_cast<float>(accumulator.asMicroseconds()) / tick.asMicroseconds();
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include "../ecs/ECS.hpp"
+
+namespace timing {
+    using Duration = std::chrono::microseconds;
+    using TimerId = std::uint64_t;
+
+    /**
+     * Simulation time of a TimerQueue. It lives in its own component because
+     * it changes every tick while the queue rarely does, so that snapshots
+     * don't have to copy the queue and its functions each time.
+     */
+    struct Clock {
+        Duration now = Duration::zero();
+    };
+
+    /**
+     * A function to be called at a given simulation time, unless `target`
+     * has been deleted by then.
+     */
+    struct TimedEvent {
+        Duration when;
+        ecs::Entity target;
+        std::function<void()> fn;
+    };
+
+    /**
+     * Min-heap of timed events keyed by deadline, driven by the simulation
+     * time of a `Clock` rather than the wall clock. Checking for due events
+     * is O(1), and popping one is O(log n).
+     *
+     * Cancellation is lazy: cancelled events are dropped from the heap when
+     * they reach its top.
+     */
+    class TimerQueue {
+     public:
+        /**
+         * Schedules `fn` to be called once the simulation time reaches
+         * `when`. Returns an ID that can be used to cancel the event.
+         */
+        TimerId schedule(Duration when, ecs::Entity target, std::function<void()> fn);
+
+        /**
+         * Cancels a scheduled event. Returns false if it has already been
+         * popped or cancelled.
+         */
+        bool cancel(TimerId);
+
+        /**
+         * Whether an event may be due at `now`, without changing the queue.
+         * Cancelled events still count until `popDue` drops them.
+         */
+        bool hasDue(Duration now) const;
+
+        /**
+         * Removes and returns the earliest event whose deadline is at or
+         * before `now`, if any.
+         */
+        std::optional<TimedEvent> popDue(Duration now);
+
+        std::size_t size() const;
+
+     private:
+        using Deadline = std::pair<Duration, TimerId>;
+
+        TimerId nextTimerId = 0;
+        std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines;
+        std::unordered_map<TimerId, TimedEvent> events;
+    };
+
+    inline TimerId TimerQueue::schedule(
+        Duration when,
+        ecs::Entity target,
+        std::function<void()> fn
+    ) {
+        TimerId id = nextTimerId++;
+
+        deadlines.push({ when, id });
+        events.insert({ id, TimedEvent { when, target, std::move(fn) } });
+        return id;
+    }
+
+    inline bool TimerQueue::cancel(TimerId id) {
+        return events.erase(id) > 0;
+    }
+
+    inline bool TimerQueue::hasDue(Duration now) const {
+        return !deadlines.empty() && deadlines.top().first <= now;
+    }
+
+    inline std::optional<TimedEvent> TimerQueue::popDue(Duration now) {
+        while (hasDue(now)) {
+            TimerId id = deadlines.top().second;
+            deadlines.pop();
+
+            auto it = events.find(id);
+
+            if (it != events.end()) {
+                TimedEvent event = std::move(it->second);
+                events.erase(it);
+                return event;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    inline std::size_t TimerQueue::size() const {
+        return events.size();
+    }
+}
@@ -0,0 +1,377 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BatchSimulation.hpp"
+#include "constants.hpp"
+#include "engine/networking/LocalSocket.hpp"
+#include "engine/rendering/RecordingBackend.hpp"
+#include "Game.hpp"
+#include "helpers/level-options.hpp"
+#include "helpers/world-hash.hpp"
+#include "Replay.hpp"
+#include "StateDelta.hpp"
+
+/**
+ * Runs the simulation without a window, at a fixed tick duration and as fast
+ * as possible, then reports the throughput and how many entities are alive.
+ *
+ * Usage: `headless [options] [ticks]`, where the options are:
+ * - none: runs one game with scripted input (100000 ticks by default)
+ * - `--record <file>`: same, but also saves a replay
+ * - `--render <file>`: same, but also runs the render path after every
+ *   tick, without a display, writing the frames into the file as text (see
+ *   `RecordingBackend`) and reporting the average draw stats
+ * - `--replay <file>`: plays a replay back, checking the world hash after
+ *   every tick. Exits with 1 on the first mismatch.
+ * - `--batch <games>`: runs many games with scripted input across all cores
+ *   and reports the aggregate ticks per second (10000 ticks by default)
+ * - `--serve <socket>`: waits for a viewer (`main --view <socket>`), then
+ *   runs one game with scripted input in real time, streaming the state to
+ *   the viewer as deltas, until it disconnects or the ticks are done
+ * - `--strict-allocations <ticks>`: aborts on any allocation made inside
+ *   a system after the given number of warm-up ticks. Only has an effect
+ *   with the meson option `allocation_tracking`. Allocations of the loop
+ *   itself, e.g by `PROFILE_COLLECT()` with the option `profiling`, and of
+ *   state transitions are reported but don't abort. Spawning a power-up
+ *   creates an entity, which allocates, so it requires `--drop-rate 0`.
+ * - any level option of `parseLevelOption`, e.g `--bricks 1000000`
+ *
+ * Malformed arguments print the usage and exit with 1, as do unreadable
+ * level or replay files.
+ */
+static int run(int argc, char** argv);
+static int usage();
+static int runScripted(
+    const LevelConfig&,
+    unsigned ticks,
+    const char* recordPath,
+    const char* renderPath,
+    unsigned strictAfter
+);
+static int playReplay(const char* replayPath);
+static int runBatch(const LevelConfig&, std::size_t gameCount, unsigned ticks);
+static int serve(const LevelConfig&, const char* socketPath, unsigned ticks);
+static Controls scriptedControls(unsigned tick);
+static void report(Game&, unsigned ticks, double seconds);
+static unsigned countSolidCells(ecs::World&);
+
+int main(int argc, char** argv) {
+    int result;
+
+    // e.g a level file that can't be read, or a socket that can't be opened
+    try {
+        result = run(argc, argv);
+    } catch (const std::runtime_error& error) {
+        std::cerr << error.what() << '\n';
+        result = 1;
+    }
+
+#ifdef ARKANOID_PROFILING
+    profiling::Profiler::instance().exportTo("trace.json", std::cout);
+#endif
+
+#ifdef ARKANOID_ALLOCATION_TRACKING
+    memory::AllocationTracker::writeReport(std::cout);
+#endif
+
+    return result;
+}
+
+int run(int argc, char** argv) {
+    LevelConfig level;
+    const char* recordPath = nullptr;
+    const char* renderPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* socketPath = nullptr;
+    std::size_t gameCount = 0;
+    unsigned ticks = 0;
+    unsigned strictAfter = 0;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (arg == "--record" && hasValue) {
+                recordPath = argv[++i];
+            } else if (arg == "--render" && hasValue) {
+                renderPath = argv[++i];
+            } else if (arg == "--replay" && hasValue) {
+                replayPath = argv[++i];
+            } else if (arg == "--strict-allocations" && hasValue) {
+                strictAfter = std::stoul(argv[++i]);
+            } else if (arg == "--batch" && hasValue) {
+                gameCount = std::stoul(argv[++i]);
+            } else if (arg == "--serve" && hasValue) {
+                socketPath = argv[++i];
+            } else if (hasValue && parseLevelOption(arg, argv[i + 1], level)) {
+                i++;
+            } else {
+                ticks = std::stoul(arg);
+            }
+        }
+    } catch (const std::invalid_argument&) {
+        return usage();
+    } catch (const std::out_of_range&) {
+        return usage();
+    }
+
+    if (replayPath) {
+        return playReplay(replayPath);
+    }
+
+    if (socketPath) {
+        return serve(level, socketPath, ticks);
+    }
+
+    if (gameCount > 0) {
+        return runBatch(level, gameCount, ticks ? ticks : 10000);
+    }
+
+    return runScripted(level, ticks ? ticks : 100000, recordPath, renderPath, strictAfter);
+}
+
+int usage() {
+    std::cerr << "usage: headless [--record <file> | --replay <file> | --batch <games> | --serve <socket>]\n"
+              << "                [--render <file>] [--strict-allocations <ticks>] [level options] [ticks]\n"
+              << "--strict-allocations requires --drop-rate 0\n";
+    return 1;
+}
+
+int runScripted(
+    const LevelConfig& level,
+    unsigned ticks,
+    const char* recordPath,
+    const char* renderPath,
+    unsigned strictAfter
+) {
+    using constants::TICK_RATE;
+
+    unsigned seed = std::mt19937::default_seed;
+
+    Game game;
+    game.init(level, seed);
+
+    Replay replay { seed, TICK_RATE, level };
+    sf::Time tickDuration = sf::microseconds(1000000 / TICK_RATE);
+
+    std::ofstream frames;
+    if (renderPath) {
+        frames.open(renderPath);
+    }
+
+    rendering::RecordingBackend backend(&frames);
+    rendering::DrawStats drawTotals;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned tick = 0; tick < ticks; tick++) {
+        if (strictAfter > 0 && tick == strictAfter) {
+            memory::AllocationTracker::setStrict(true);
+        }
+
+        Controls controls = scriptedControls(tick);
+        game.update(tickDuration, controls);
+
+        if (recordPath) {
+            replay.record(controls, hashWorld(game.getWorld()));
+        }
+
+        if (renderPath) {
+            rendering::DrawStats stats = game.render(backend);
+            drawTotals.drawCalls += stats.drawCalls;
+            drawTotals.vertices += stats.vertices;
+        }
+
+        PROFILE_COLLECT();
+        END_ALLOCATION_FRAME();
+    }
+
+    memory::AllocationTracker::setStrict(false);
+
+    auto end = std::chrono::steady_clock::now();
+    report(game, ticks, std::chrono::duration<double>(end - start).count());
+
+    if (renderPath && ticks > 0) {
+        std::cout << "draw calls per frame: " << double(drawTotals.drawCalls) / ticks << '\n';
+        std::cout << "vertices per frame: " << double(drawTotals.vertices) / ticks << '\n';
+    }
+
+    if (recordPath) {
+        std::ofstream file(recordPath, std::ios::binary);
+        saveReplay(file, replay);
+    }
+
+    return 0;
+}
+
+int playReplay(const char* replayPath) {
+    std::ifstream file(replayPath, std::ios::binary);
+    Replay replay = loadReplay(file);
+
+    Game game;
+    game.init(replay.level, replay.seed);
+
+    sf::Time tickDuration = sf::microseconds(1000000 / replay.tickRate);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned tick = 0; tick < replay.size(); tick++) {
+        game.update(tickDuration, replay.controlsAt(tick));
+
+        if (hashWorld(game.getWorld()) != replay.hashes[tick]) {
+            std::cerr << "replay diverged at tick " << tick << '\n';
+            return 1;
+        }
+
+        PROFILE_COLLECT();
+        END_ALLOCATION_FRAME();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    report(game, replay.size(), std::chrono::duration<double>(end - start).count());
+
+    return 0;
+}
+
+int runBatch(const LevelConfig& level, std::size_t gameCount, unsigned ticks) {
+    using constants::TICK_RATE;
+
+    // The calling thread works too
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    BatchSimulation simulation(level, gameCount, std::mt19937::default_seed, threadCount);
+
+    std::vector<Controls> controls(gameCount);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // The scripted input only changes once per second
+    for (unsigned tick = 0; tick < ticks; tick += TICK_RATE) {
+        unsigned chunk = std::min(TICK_RATE, ticks - tick);
+        std::fill(controls.begin(), controls.end(), scriptedControls(tick));
+        simulation.step(controls, chunk);
+
+        PROFILE_COLLECT();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << "games: " << gameCount << '\n';
+    std::cout << "threads: " << threadCount + 1 << '\n';
+    std::cout << "ticks per game: " << ticks << '\n';
+    std::cout << "seconds: " << seconds << '\n';
+    std::cout << "aggregate ticks per second: " << gameCount * ticks / seconds << '\n';
+
+    return 0;
+}
+
+/**
+ * Sends a delta of the world to the viewer after every tick, against the
+ * latest snapshot it acknowledged. Acknowledgements are snapshot IDs, as
+ * little-endian uint64 messages. With 0 ticks, runs until the viewer
+ * disconnects.
+ */
+int serve(const LevelConfig& level, const char* socketPath, unsigned ticks) {
+    using constants::TICK_RATE;
+
+    std::cout << "waiting for a viewer on " << socketPath << '\n';
+    networking::LocalSocket socket = networking::LocalSocket::listen(socketPath);
+
+    std::vector<std::uint8_t> header = StateDelta::encodeStreamHeader({
+        level.boardWidth,
+        level.boardHeight
+    });
+    socket.send(header.data(), header.size());
+
+    Game game;
+    game.init(level, std::mt19937::default_seed);
+    ecs::World& world = game.getWorld();
+
+    DeltaEncoder encoder;
+    std::vector<std::uint8_t> delta;
+    std::vector<std::uint8_t> acknowledgement;
+    sf::Time tickDuration = sf::microseconds(1000000 / TICK_RATE);
+    std::chrono::microseconds tickInterval(1000000 / TICK_RATE);
+    std::size_t totalBytes = 0;
+    unsigned tick = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (; (ticks == 0 || tick < ticks) && !socket.isClosed(); tick++) {
+        game.update(tickDuration, scriptedControls(tick));
+
+        delta.clear();
+        encoder.encode(world, world.saveSnapshot(), delta);
+        socket.send(delta.data(), delta.size());
+        totalBytes += delta.size();
+
+        while (socket.receive(acknowledgement)) {
+            if (acknowledgement.size() != 8) {
+                std::cerr << "malformed acknowledgement\n";
+                return 1;
+            }
+
+            ecs::SnapshotId acknowledged = 0;
+            for (std::size_t i = 0; i < 8; i++) {
+                acknowledged |= ecs::SnapshotId(acknowledgement[i]) << (8 * i);
+            }
+
+            encoder.acknowledge(acknowledged);
+        }
+
+        PROFILE_COLLECT();
+        END_ALLOCATION_FRAME();
+
+        std::this_thread::sleep_until(start + tickInterval * (tick + 1));
+    }
+
+    std::cout << "ticks: " << tick << '\n';
+    std::cout << "bytes per tick: " << (tick ? totalBytes / tick : 0) << '\n';
+
+    return 0;
+}
+
+/**
+ * Keeps the launch button pressed and sweeps the paddle from one side
+ * to the other every second.
+ */
+Controls scriptedControls(unsigned tick) {
+    using constants::TICK_RATE;
+
+    Controls controls;
+    controls.launch = true;
+    controls.left = (tick / TICK_RATE) % 2 == 0;
+    controls.right = !controls.left;
+
+    return controls;
+}
+
+void report(Game& game, unsigned ticks, double seconds) {
+    ecs::World& world = game.getWorld();
+
+    std::cout << "ticks: " << ticks << '\n';
+    std::cout << "seconds: " << seconds << '\n';
+    std::cout << "ticks per second: " << ticks / seconds << '\n';
+    std::cout << "balls: " << world.count<Ball>() << '\n';
+    std::cout << "power-ups: " << world.count<PowerUp>() << '\n';
+    std::cout << "bricks: " << world.count<Brick>() + countSolidCells(world) << '\n';
+    std::cout << "bounded entities: " << world.count<Bounds>() << '\n';
+}
+
+unsigned countSolidCells(ecs::World& world) {
+    unsigned result = 0;
+
+    world.query<TileMap>([&result](ecs::Entity, const TileMap& tileMap) {
+        for (unsigned i = 0; i < tileMap.cells.size(); i++) {
+            result += tileMap.isSolid(i);
+        }
+    });
+
+    return result;
+}
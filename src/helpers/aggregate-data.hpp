@@ -5,23 +5,8 @@ struct CircleData {
     const Position& position;
 };
 
-struct RectangleData {
-    const Rectangle& body;
-    const Position& position;
-
-    float leftX() const {
-        return position.x - body.width / 2;
-    };
-
-    float rightX() const {
-        return position.x + body.width / 2;
-    };
-
-    float topY() const {
-        return position.y - body.height / 2;
-    };
-
-    float bottomY() const {
-        return position.y + body.height / 2;
-    };
+struct SweptCircleData {
+    CircleData nextX;
+    CircleData nextY;
+    Bounds sweptBounds;
 };
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../components/Bounds.hpp"
+#include "../components/Circle.hpp"
+#include "../components/Position.hpp"
+#include "../components/Rectangle.hpp"
+#include "../components/TileMap.hpp"
+
+inline Bounds computeBounds(const Position& pos, const Rectangle& rect) {
+    return Bounds {
+        pos.x - rect.width / 2,
+        pos.y - rect.height / 2,
+        pos.x + rect.width / 2,
+        pos.y + rect.height / 2
+    };
+}
+
+inline Bounds computeBounds(const Position& pos, const Circle& circle) {
+    return Bounds {
+        pos.x - circle.radius,
+        pos.y - circle.radius,
+        pos.x + circle.radius,
+        pos.y + circle.radius
+    };
+}
+
+inline Bounds computeBounds(const TileMap& tileMap) {
+    return Bounds {
+        tileMap.origin.x,
+        tileMap.origin.y,
+        tileMap.origin.x + tileMap.columns * tileMap.cellWidth,
+        tileMap.origin.y + tileMap.rows * tileMap.cellHeight
+    };
+}
+
+inline bool overlaps(const Bounds& lhs, const Bounds& rhs) {
+    return lhs.minX < rhs.maxX && rhs.minX < lhs.maxX
+        && lhs.minY < rhs.maxY && rhs.minY < lhs.maxY;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "../components/LevelConfig.hpp"
+#include "../LevelFile.hpp"
+
+/**
+ * Applies a command line option that describes the level:
+ * `--board <width>x<height>`, `--bricks <count>`, `--balls <count>`,
+ * `--drop-rate <percentage>`, `--layout <grid|scatter|clustered>` or
+ * `--level <file>`. The latter reads the whole configuration from a level
+ * file, replacing the options before it.
+ *
+ * Returns false if `option` isn't a level option. Throws
+ * `std::invalid_argument` if the value is malformed, or
+ * `std::runtime_error` if the level file can't be read.
+ */
+inline bool parseLevelOption(
+    const std::string& option,
+    const std::string& value,
+    LevelConfig& level
+) {
+    if (option == "--board") {
+        std::size_t separator = value.find('x');
+
+        if (separator == std::string::npos) {
+            throw std::invalid_argument("--board expects <width>x<height>");
+        }
+
+        level.boardWidth = std::stof(value.substr(0, separator));
+        level.boardHeight = std::stof(value.substr(separator + 1));
+    } else if (option == "--bricks") {
+        level.brickCount = std::stoul(value);
+    } else if (option == "--balls") {
+        level.ballCount = std::max(1ul, std::stoul(value));
+    } else if (option == "--drop-rate") {
+        level.powerUpDropRate = std::stoi(value);
+    } else if (option == "--layout") {
+        if (value == "grid") {
+            level.layout = BrickLayout::Grid;
+        } else if (value == "scatter") {
+            level.layout = BrickLayout::Scatter;
+        } else if (value == "clustered") {
+            level.layout = BrickLayout::Clustered;
+        } else {
+            throw std::invalid_argument("unknown layout: " + value);
+        }
+    } else if (option == "--level") {
+        level = LevelFile(value).config();
+    } else {
+        return false;
+    }
+
+    return true;
+}
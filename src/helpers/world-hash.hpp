@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+#include "../engine-glue/ecs.hpp"
+
+namespace worldhash {
+    namespace __detail {
+        constexpr std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+        constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+        inline void hashBytes(std::uint64_t& hash, const void* data, std::size_t size) {
+            auto bytes = static_cast<const unsigned char*>(data);
+
+            for (std::size_t i = 0; i < size; i++) {
+                hash = (hash ^ bytes[i]) * FNV_PRIME;
+            }
+        }
+
+        template<typename T>
+        inline void hashValue(std::uint64_t& hash, const T& value) {
+            hashBytes(hash, &value, sizeof(T));
+        }
+
+        /**
+         * Hashes the x/y pair of every entity with a T component, in entity
+         * order, since the iteration order of the world is unspecified.
+         */
+        template<typename T>
+        inline void hashPoints(std::uint64_t& hash, ecs::World& world) {
+            std::pmr::vector<std::pair<ecs::Entity, T>> points(&world.frameArena());
+            points.reserve(world.count<T>());
+
+            world.query<T>([&points](ecs::Entity id, const T& point) {
+                points.push_back({id, point});
+            });
+
+            std::sort(points.begin(), points.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+            });
+
+            hashValue(hash, points.size());
+
+            for (const auto& [id, point] : points) {
+                hashValue(hash, id);
+                hashValue(hash, point.x);
+                hashValue(hash, point.y);
+            }
+        }
+    }
+}
+
+/**
+ * Returns a fingerprint of the simulation state: positions, velocities
+ * and brick cells. Two runs that diverge in any of them also diverge
+ * in the hash, which is how replays are checked.
+ */
+inline std::uint64_t hashWorld(ecs::World& world) {
+    using namespace worldhash::__detail;
+
+    std::uint64_t hash = FNV_OFFSET_BASIS;
+    hashPoints<Position>(hash, world);
+    hashPoints<Velocity>(hash, world);
+
+    hashValue(hash, world.count<Brick>());
+    hashValue(hash, world.count<PiercingBall>());
+
+    world.query<TileMap>([&hash](ecs::Entity, const TileMap& tileMap) {
+        for (const TileCell& cell : tileMap.cells) {
+            hashValue(hash, cell.hitPoints);
+        }
+    });
+
+    return hash;
+}
@@ -0,0 +1,67 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "engine-glue/ecs.hpp"
+#include "helpers/level-options.hpp"
+#include "LevelFile.hpp"
+#include "systems/level-loading-system/include.hpp"
+
+/**
+ * Builds a level with the built-in generator and writes it as a level file,
+ * which both executables can then load with `--level <file>`.
+ *
+ * Usage: `level-converter [level options] <output>`, with the level options
+ * of `parseLevelOption`. Without options, the classic level is written.
+ * Malformed arguments print the usage and exit with 1.
+ */
+static int usage();
+
+int main(int argc, char** argv) {
+    LevelConfig level;
+    const char* outputPath = nullptr;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            if (i + 1 < argc && parseLevelOption(argv[i], argv[i + 1], level)) {
+                i++;
+            } else {
+                outputPath = argv[i];
+            }
+        }
+    } catch (const std::invalid_argument&) {
+        return usage();
+    } catch (const std::out_of_range&) {
+        return usage();
+    } catch (const std::runtime_error& error) {
+        // e.g a level file that can't be read
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+
+    if (!outputPath) {
+        return usage();
+    }
+
+    // Levels are large, so the world lives on the heap
+    auto world = std::make_unique<ecs::World>();
+    useLevelLoadingSystem(*world, level);
+
+    std::ofstream file(outputPath, std::ios::binary);
+    saveLevel(file, *world);
+
+    if (!file) {
+        std::cerr << "cannot write " << outputPath << "\n";
+        return 1;
+    }
+
+    std::cout << "wrote " << world->count<Brick>() << " brick entities, "
+              << world->count<Wall>() << " walls and "
+              << world->count<TileMap>() << " tile maps to " << outputPath << "\n";
+}
+
+int usage() {
+    std::cerr << "usage: level-converter [level options] <output>\n";
+    return 1;
+}
@@ -1,20 +1,262 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 #include <SFML/Graphics.hpp>
 #include "constants.hpp"
+#include "engine/networking/LocalSocket.hpp"
+#include "engine/rendering/SfmlBackend.hpp"
+#include "engine/rendering/SnapshotBuffer.hpp"
+#include "engine/timing/FixedTimestep.hpp"
 #include "Game.hpp"
+#include "helpers/level-options.hpp"
+#include "helpers/world-hash.hpp"
+#include "InputQueue.hpp"
+#include "Replay.hpp"
+#include "StateDelta.hpp"
+#include "systems/rendering-system/include.hpp"
+
+static int usage();
+static int view(const char* socketPath);
+static std::string titleWithStats(const char* title, const rendering::DrawStats&);
+
+// The draw stats in the window title are refreshed at this period
+static const sf::Time STATS_PERIOD = sf::seconds(1);
+
+/**
+ * Usage: `main [level options] [replay-file]`, with the level options of
+ * `parseLevelOption`. If a file is given, the run is recorded into it so
+ * that it can be played back by `headless --replay`.
+ *
+ * With `main --view <socket>`, only draws the game streamed by
+ * `headless --serve <socket>`.
+ *
+ * Malformed arguments print the usage and exit with 1.
+ */
+int main(int argc, char** argv) {
+    using constants::TICK_RATE;
+
+    LevelConfig level;
+    const char* replayPath = nullptr;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            if (i + 1 < argc && std::string(argv[i]) == "--view") {
+                return view(argv[i + 1]);
+            } else if (i + 1 < argc && parseLevelOption(argv[i], argv[i + 1], level)) {
+                i++;
+            } else {
+                replayPath = argv[i];
+            }
+        }
+    } catch (const std::invalid_argument&) {
+        return usage();
+    } catch (const std::out_of_range&) {
+        return usage();
+    } catch (const std::runtime_error& error) {
+        // e.g a level file that can't be read
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+
+    const char* title = "ECS Arkanoid";
+    sf::RenderWindow window(sf::VideoMode(level.boardWidth, level.boardHeight), title);
+
+    std::random_device randomDevice;
+    unsigned seed = randomDevice();
 
-int main(int, char**) {
-    using constants::WINDOW_WIDTH;
-    using constants::WINDOW_HEIGHT;
-    sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "ECS Arkanoid");
     Game game;
-    game.init(WINDOW_WIDTH, WINDOW_HEIGHT);
+    game.init(level, seed, LevelPreparation::Mode::Background);
+
+    std::optional<Replay> replay;
+    if (replayPath) {
+        replay = Replay { seed, TICK_RATE, level };
+    }
 
     window.setFramerateLimit(60);
     window.setPosition({200, 100});
+    window.setKeyRepeatEnabled(false);
+
+    // Frame N is drawn by the render thread while frame N + 1 is simulated
+    rendering::SnapshotBuffer snapshots;
+    window.setActive(false);
+
+    // Stats of the latest frame drawn, shown in the title by the main thread
+    std::atomic<unsigned> drawCalls { 0 };
+    std::atomic<std::size_t> drawnVertices { 0 };
+
+    std::thread renderThread([&window, &snapshots, &drawCalls, &drawnVertices] {
+        rendering::SfmlBackend backend(window);
+        window.setActive(true);
+
+        auto draw = [&](const rendering::CommandList& commandList) {
+            window.clear();
+            rendering::DrawStats stats = backend.draw(commandList);
+            window.display();
+
+            drawCalls.store(stats.drawCalls, std::memory_order_relaxed);
+            drawnVertices.store(stats.vertices, std::memory_order_relaxed);
+        };
+
+        while (snapshots.consume(draw));
+
+        window.setActive(false);
+    });
 
+    using constants::MAX_CATCH_UP_TICKS;
+    timing::FixedTimestep timestep(TICK_RATE, MAX_CATCH_UP_TICKS);
+
+    // Key events are stamped with this clock, which the ticks follow
     sf::Clock clock;
+    sf::Time lastFrameTime = sf::Time::Zero;
+    sf::Time simulatedUntil = sf::Time::Zero;
+    sf::Time statsShownAt = sf::Time::Zero;
+    InputQueue input;
+    bool running = true;
 
-    while (window.isOpen()) {
+    auto pollEvents = [&window, &clock, &input, &running] {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            sf::Time timestamp = clock.getElapsedTime();
+
+            if (event.type == sf::Event::Closed) {
+                running = false;
+            } else if (event.type == sf::Event::LostFocus) {
+                input.releaseAll(timestamp);
+            } else if (event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased) {
+                bool pressed = event.type == sf::Event::KeyPressed;
+
+                switch (event.key.code) {
+                    case sf::Keyboard::Left:
+                        input.push(timestamp, InputQueue::LEFT, pressed);
+                        break;
+                    case sf::Keyboard::Right:
+                        input.push(timestamp, InputQueue::RIGHT, pressed);
+                        break;
+                    case sf::Keyboard::Space:
+                        input.push(timestamp, InputQueue::LAUNCH, pressed);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    };
+
+    while (running) {
+        pollEvents();
+
+        sf::Time frameTime = clock.getElapsedTime();
+        timestep.advance(frameTime - lastFrameTime, [&](const sf::Time& tick) {
+            Controls controls = input.take(simulatedUntil, simulatedUntil + tick);
+            simulatedUntil += tick;
+
+            game.update(tick, controls);
+
+            if (replay) {
+                replay->record(controls, hashWorld(game.getWorld()));
+            }
+
+            END_ALLOCATION_FRAME();
+        });
+
+        // Time dropped by the timestep is never simulated, so the events
+        // that follow belong to the next ticks
+        lastFrameTime = frameTime;
+        simulatedUntil = frameTime - timestep.tickDuration() * timestep.alpha();
+
+        game.extract(snapshots.back(), timestep.alpha());
+
+        // Events are stamped when they are polled, so they keep being polled
+        // while the render thread finishes the previous frame
+        while (!snapshots.publishFor(std::chrono::milliseconds(1))) {
+            pollEvents();
+        }
+
+        if (frameTime - statsShownAt >= STATS_PERIOD) {
+            rendering::DrawStats stats;
+            stats.drawCalls = drawCalls.load(std::memory_order_relaxed);
+            stats.vertices = drawnVertices.load(std::memory_order_relaxed);
+
+            window.setTitle(titleWithStats(title, stats));
+            statsShownAt = frameTime;
+        }
+
+        PROFILE_COLLECT();
+    }
+
+    snapshots.close();
+    renderThread.join();
+    window.close();
+
+    if (replay) {
+        std::ofstream file(replayPath, std::ios::binary);
+        saveReplay(file, *replay);
+    }
+
+#ifdef ARKANOID_PROFILING
+    profiling::Profiler::instance().exportTo("trace.json", std::cout);
+#endif
+
+#ifdef ARKANOID_ALLOCATION_TRACKING
+    memory::AllocationTracker::writeReport(std::cout);
+#endif
+}
+
+int usage() {
+    std::cerr << "usage: main [level options] [replay-file]\n"
+              << "       main --view <socket>\n";
+    return 1;
+}
+
+/**
+ * `title`, followed by the number of draw calls and vertices of a frame,
+ * which is how they can be watched while playing.
+ */
+std::string titleWithStats(const char* title, const rendering::DrawStats& stats) {
+    return std::string(title)
+        + " - " + std::to_string(stats.drawCalls) + " draw calls"
+        + ", " + std::to_string(stats.vertices) + " vertices";
+}
+
+/**
+ * Applies the deltas of the server to a local world as they arrive,
+ * acknowledging the latest one after each frame, and draws that world.
+ * The viewer doesn't simulate anything, so it draws whole ticks without
+ * interpolation.
+ */
+int view(const char* socketPath) {
+    networking::LocalSocket socket = networking::LocalSocket::connect(socketPath);
+    std::vector<std::uint8_t> message;
+
+    if (!socket.receive(message, true)) {
+        std::cerr << "the server closed the stream\n";
+        return 1;
+    }
+
+    StateDelta::StreamHeader header = StateDelta::decodeStreamHeader(message.data(), message.size());
+
+    const char* title = "ECS Arkanoid (viewer)";
+    sf::RenderWindow window(sf::VideoMode(header.boardWidth, header.boardHeight), title);
+    window.setFramerateLimit(60);
+    window.setPosition({200, 100});
+
+    rendering::SfmlBackend backend(window);
+    rendering::CommandList commandList;
+
+    // Worlds are large, so the viewer one lives on the heap
+    auto world = std::make_unique<ecs::World>();
+    DeltaDecoder decoder;
+    sf::Clock statsClock;
+
+    while (window.isOpen() && !socket.isClosed()) {
         sf::Event event;
         while (window.pollEvent(event)) {
             if (event.type == sf::Event::Closed) {
@@ -22,10 +264,34 @@ int main(int, char**) {
             }
         }
 
+        std::optional<ecs::SnapshotId> latest;
+        while (socket.receive(message)) {
+            latest = decoder.apply(*world, message.data(), message.size());
+        }
+
+        if (latest) {
+            std::uint8_t acknowledgement[8];
+            for (std::size_t i = 0; i < 8; i++) {
+                acknowledgement[i] = static_cast<std::uint8_t>(*latest >> (8 * i));
+            }
+
+            socket.send(acknowledgement, sizeof(acknowledgement));
+        }
+
+        commandList.clear();
+        useRenderingSystem(*world, commandList, 1);
+
         window.clear();
-        sf::Time elapsedTime = clock.restart();
-        game.update(elapsedTime);
-        game.render(window);
+        rendering::DrawStats stats = backend.draw(commandList);
         window.display();
+
+        if (statsClock.getElapsedTime() >= STATS_PERIOD) {
+            window.setTitle(titleWithStats(title, stats));
+            statsClock.restart();
+        }
+
+        PROFILE_COLLECT();
     }
+
+    return 0;
 }
@@ -2,10 +2,12 @@
 
 #include "../engine-glue/ecs.hpp"
 #include "../engine/state-management/include.hpp"
+#include "../systems/bounds-system/include.hpp"
 #include "../systems/collision-handler-system/include.hpp"
 #include "../systems/collision-system/include.hpp"
 #include "../systems/game-over-system/include.hpp"
 #include "../systems/input-system/include.hpp"
+#include "../systems/interpolation-system/include.hpp"
 #include "../systems/launching-system/include.hpp"
 #include "../systems/movement-system/include.hpp"
 #include "../systems/rendering-system/include.hpp"
@@ -25,12 +27,14 @@ class RunningState : public state::EffectState {
  public:
     RunningState(
         ecs::World& world,
-        state::StateMachine& stateMachine
-    ) : world(world), stateMachine(stateMachine) {
-        listenerId = world.createEntity();
-    }
+        state::StateMachine& stateMachine,
+        const Controls& controls
+    ) : world(world), stateMachine(stateMachine), controls(controls) { }
 
     virtual void onEnter() override {
+        // Created after the waiting state swapped the level in, which
+        // replaced every entity
+        listenerId = world.createEntity();
         useLaunchingSystem(world);
 
         listenToCollisions();
@@ -41,20 +45,25 @@ class RunningState : public state::EffectState {
         unsigned elapsedTimeMicro = elapsedTime.asMicroseconds();
         float normalizedElapsedTime = elapsedTimeMicro / 1000000.0;
 
-        useInputSystem(world);
+        useInterpolationSystem(world);
+        useInputSystem(world, controls);
         useCollisionSystem(world, normalizedElapsedTime);
         useMovementSystem(world, normalizedElapsedTime);
-        useTimingSystem(world);
+        useBoundsSystem(world);
+        useTimingSystem(world, normalizedElapsedTime);
         useGameOverSystem(world);
+
+        world.frameArena().reset();
     }
 
-    virtual void render(sf::RenderWindow& window) override {
-        useRenderingSystem(world, window);
+    virtual void render(rendering::CommandList& commandList, float interpolation) override {
+        useRenderingSystem(world, commandList, interpolation);
     }
 
  private:
     ecs::World& world;
     state::StateMachine& stateMachine;
+    const Controls& controls;
     ecs::Entity listenerId;
 
     template<typename T>
@@ -65,6 +74,7 @@ class RunningState : public state::EffectState {
     void listenToCollisions() {
         listenToCollisions<Ball, Brick>();
         listenToCollisions<Ball, Paddle>();
+        listenToCollisions<Ball, TileMap>();
         listenToCollisions<Ball, Wall>();
         listenToCollisions<Paddle, PowerUp>();
         listenToCollisions<Paddle, Wall>();
@@ -77,8 +87,9 @@ class RunningState : public state::EffectState {
     }
 
     void listenToGameOver() {
+        // The waiting state swaps a fresh copy of the level in, replacing
+        // every entity
         auto callback = [this] {
-            world.clear();
             stateMachine.pushState("waiting");
         };
 
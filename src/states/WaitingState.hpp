@@ -1,10 +1,13 @@
 #pragma once
 
+#include <vector>
 #include "../engine-glue/ecs.hpp"
 #include "../engine/state-management/include.hpp"
+#include "../LevelPreparation.hpp"
+#include "../systems/bounds-system/include.hpp"
 #include "../systems/collision-system/include.hpp"
 #include "../systems/input-system/include.hpp"
-#include "../systems/level-loading-system/include.hpp"
+#include "../systems/interpolation-system/include.hpp"
 #include "../systems/movement-system/include.hpp"
 #include "../systems/rendering-system/include.hpp"
 
@@ -12,46 +15,68 @@ class WaitingState : public state::EffectState {
  public:
     WaitingState(
         ecs::World& world,
-        state::StateMachine& stateMachine
-    ) : world(world), stateMachine(stateMachine) { }
+        state::StateMachine& stateMachine,
+        const Controls& controls,
+        const LevelConfig& level,
+        LevelPreparation::Mode preparation
+    ) : world(world), stateMachine(stateMachine), controls(controls),
+        levelPreparation(level, world.randomEngine(), preparation) { }
 
     virtual void onEnter() override {
-        useLevelLoadingSystem(world);
+        // The level is prepared once, or in the background since the
+        // previous round
+        levelPreparation.swapInto(world);
 
         useEffect([this] {
-            ecs::Entity ball = world.unique<Ball>();
+            const ecs::World& constWorld = world;
             ecs::Entity paddle = world.unique<Paddle>();
+            const Position& paddlePos = constWorld.getData<Position>(paddle);
+            std::vector<ecs::Entity> balls;
 
-            const Position& ballPos = world.getData<Position>(ball);
-            const Position& paddlePos = world.getData<Position>(paddle);
+            world.findAll<Ball>()
+                .forEach([&balls](ecs::Entity ball) {
+                    balls.push_back(ball);
+                });
 
-            world.addComponent(ball, Link { paddle, ballPos - paddlePos });
+            for (ecs::Entity ball : balls) {
+                const Position& ballPos = constWorld.getData<Position>(ball);
+                world.addComponent(ball, Link { paddle, ballPos - paddlePos });
+            }
 
-            return [this, ball] {
-                world.removeComponent<Link>(ball);
+            return [this, balls] {
+                for (ecs::Entity ball : balls) {
+                    world.removeComponent<Link>(ball);
+                }
             };
         });
     }
 
     virtual void update(const sf::Time& elapsedTime) override {
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) {
+        if (controls.launch) {
             stateMachine.pushState("running");
+            world.frameArena().reset();
             return;
         }
 
         unsigned elapsedTimeMicro = elapsedTime.asMicroseconds();
         float normalizedElapsedTime = elapsedTimeMicro / 1000000.0;
 
-        useInputSystem(world);
+        useInterpolationSystem(world);
+        useInputSystem(world, controls);
         useCollisionSystem(world, normalizedElapsedTime);
         useMovementSystem(world, normalizedElapsedTime);
+        useBoundsSystem(world);
+
+        world.frameArena().reset();
     }
 
-    virtual void render(sf::RenderWindow& window) override {
-        useRenderingSystem(world, window);
+    virtual void render(rendering::CommandList& commandList, float interpolation) override {
+        useRenderingSystem(world, commandList, interpolation);
     }
 
  private:
     ecs::World& world;
     state::StateMachine& stateMachine;
+    const Controls& controls;
+    LevelPreparation levelPreparation;
 };
@@ -0,0 +1,32 @@
+#include "include.hpp"
+
+#include "../../helpers/bounds.hpp"
+
+template<typename T>
+static void refreshBounds(ecs::World&);
+
+void useBoundsSystem(ecs::World& world) {
+    PROFILE_SYSTEM("useBoundsSystem");
+
+    refreshBounds<Velocity>(world);
+    refreshBounds<Link>(world);
+}
+
+template<typename T>
+void refreshBounds(ecs::World& world) {
+    world.findAll<T>()
+        .template join<Bounds>()
+        .template join<Position>()
+        .template join<Rectangle>()
+        .forEach([](Bounds& bounds, const Position& pos, const Rectangle& rect) {
+            bounds = computeBounds(pos, rect);
+        });
+
+    world.findAll<T>()
+        .template join<Bounds>()
+        .template join<Position>()
+        .template join<Circle>()
+        .forEach([](Bounds& bounds, const Position& pos, const Circle& circle) {
+            bounds = computeBounds(pos, circle);
+        });
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "../../engine-glue/ecs.hpp"
+
+void useBoundsSystem(ecs::World&);
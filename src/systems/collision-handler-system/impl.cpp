@@ -3,21 +3,28 @@
 #include <bitset>
 #include <cassert>
 #include "../../constants.hpp"
+#include "../../engine/logging/Logger.hpp"
 #include "../../engine/misc/check-percentage.hpp"
-#include "../../helpers/aggregate-data.hpp"
 #include "../../helpers/ball-paddle-contact.hpp"
+#include "../../helpers/bounds.hpp"
+#include "../timing-system/include.hpp"
 
-#include <iostream>
-
-template<typename F>
+template<typename T, typename F>
 static void handleBounceCollisions(
     ecs::World&,
     ecs::Entity,
-    const metadata::MultiRectCollisionData&,
+    const std::pmr::vector<T>&,
     F
 );
 static bool handleBallBrickCollision(ecs::World&, ecs::Entity, ecs::Entity);
+static bool handleBallTileCollision(
+    ecs::World&,
+    ecs::Entity,
+    const metadata::TileCollisionData&
+);
 static bool handleBallWallCollision(ecs::World&, ecs::Entity, ecs::Entity);
+static bool shouldDropPowerUp(ecs::World&);
+static void spawnPowerUp(ecs::World&, const Position&);
 
 template<>
 void useCollisionSystem<Ball, Paddle>(
@@ -25,10 +32,14 @@ void useCollisionSystem<Ball, Paddle>(
     ecs::Entity ballId,
     metadata::CollisionData<Ball, Paddle> paddleIds
 ) {
+    PROFILE_SYSTEM("useCollisionSystem<Ball, Paddle>");
+
+    const ecs::World& constWorld = world;
+
     for (ecs::Entity paddleId : paddleIds) {
-        std::cout << "Collision detected with Paddle\n";
-        const Position& ballPos = world.getData<Position>(ballId);
-        const Position& paddlePos = world.getData<Position>(paddleId);
+        LOG_DEBUG("Collision detected with Paddle");
+        const Position& ballPos = constWorld.getData<Position>(ballId);
+        const Position& paddlePos = constWorld.getData<Position>(paddleId);
         world.getData<Velocity>(ballId) = getBallNewVelocity(ballPos, paddlePos);
     }
 }
@@ -39,12 +50,40 @@ void useCollisionSystem<Ball, Brick>(
     ecs::Entity ballId,
     metadata::CollisionData<Ball, Brick> collisions
 ) {
+    PROFILE_SYSTEM("useCollisionSystem<Ball, Brick>");
+
     handleBounceCollisions(
         world,
         ballId,
         collisions,
-        [](ecs::World& world, ecs::Entity ballId, ecs::Entity brickId) {
-            return handleBallBrickCollision(world, ballId, brickId);
+        [](
+            ecs::World& world,
+            ecs::Entity ballId,
+            const metadata::RectCollisionData& collisionData
+        ) {
+            return handleBallBrickCollision(world, ballId, collisionData.objectId);
+        }
+    );
+}
+
+template<>
+void useCollisionSystem<Ball, TileMap>(
+    ecs::World& world,
+    ecs::Entity ballId,
+    metadata::CollisionData<Ball, TileMap> collisions
+) {
+    PROFILE_SYSTEM("useCollisionSystem<Ball, TileMap>");
+
+    handleBounceCollisions(
+        world,
+        ballId,
+        collisions,
+        [](
+            ecs::World& world,
+            ecs::Entity ballId,
+            const metadata::TileCollisionData& collisionData
+        ) {
+            return handleBallTileCollision(world, ballId, collisionData);
         }
     );
 }
@@ -55,12 +94,18 @@ void useCollisionSystem<Ball, Wall>(
     ecs::Entity ballId,
     metadata::CollisionData<Ball, Wall> collisions
 ) {
+    PROFILE_SYSTEM("useCollisionSystem<Ball, Wall>");
+
     handleBounceCollisions(
         world,
         ballId,
         collisions,
-        [](ecs::World& world, ecs::Entity ballId, ecs::Entity wallId) {
-            return handleBallWallCollision(world, ballId, wallId);
+        [](
+            ecs::World& world,
+            ecs::Entity ballId,
+            const metadata::RectCollisionData& collisionData
+        ) {
+            return handleBallWallCollision(world, ballId, collisionData.objectId);
         }
     );
 }
@@ -71,24 +116,27 @@ void useCollisionSystem<Paddle, PowerUp>(
     ecs::Entity paddleId,
     metadata::CollisionData<Paddle, PowerUp> powerUpIds
 ) {
+    PROFILE_SYSTEM("useCollisionSystem<Paddle, PowerUp>");
+
     for (ecs::Entity powerUpId : powerUpIds) {
-        std::cout << "Collision detected between Paddle and PowerUp " << powerUpId << "\n";
+        LOG_DEBUG("Collision detected between Paddle and PowerUp {}", powerUpId);
         world.deleteEntity(powerUpId);
 
+        // In entity order, so that resimulating queues their timers the same way
         world.findAll<Ball>()
-            .forEach([&world](ecs::Entity ballId) {
+            .orderedForEach([&world](ecs::Entity ballId) {
                 if (world.hasComponent<PiercingBall>(ballId)) {
                     return;
                 }
 
-                std::cout << "Ball is now in piercing mode.\n";
+                LOG_INFO("Ball is now in piercing mode.");
 
                 auto expirationFn = [&world, ballId] {
-                    std::cout << "Piercing mode expired.\n";
+                    LOG_INFO("Piercing mode expired.");
                     world.removeComponent<PiercingBall>(ballId);
                 };
 
-                world.createEntity(createEvent(3000, expirationFn));
+                scheduleEvent(world, 3000, ballId, expirationFn);
 
                 world.addComponent(ballId, PiercingBall { });
             });
@@ -101,25 +149,24 @@ void useCollisionSystem<Paddle, Wall>(
     ecs::Entity paddleId,
     metadata::CollisionData<Paddle, Wall> wallIds
 ) {
+    PROFILE_SYSTEM("useCollisionSystem<Paddle, Wall>");
+
     assert(wallIds.size() == 1);
 
     ecs::Entity wallId = wallIds[0];
-    std::cout << "Collision detected between Paddle and Wall " << wallId << "\n";
+    LOG_DEBUG("Collision detected between Paddle and Wall {}", wallId);
 
-    Rectangle& paddleBody = world.getData<Rectangle>(paddleId);
+    const ecs::World& constWorld = world;
     Position& paddlePos = world.getData<Position>(paddleId);
-    Velocity& paddleVelocity = world.getData<Velocity>(paddleId);
-    RectangleData paddle { paddleBody, paddlePos };
-
-    const Rectangle& wallBody = world.getData<Rectangle>(wallId);
-    const Position& wallPos = world.getData<Position>(wallId);
-    RectangleData wall { wallBody, wallPos };
+    const Velocity& paddleVelocity = constWorld.getData<Velocity>(paddleId);
+    Bounds& paddle = world.getData<Bounds>(paddleId);
+    const Bounds& wall = constWorld.getData<Bounds>(wallId);
 
     std::array<float, 4> ts {
-        (wall.rightX() - paddle.leftX()) / paddleVelocity.x,
-        (wall.leftX() - paddle.rightX()) / paddleVelocity.x,
-        (wall.bottomY() - paddle.topY()) / paddleVelocity.y,
-        (wall.topY() - paddle.bottomY()) / paddleVelocity.y
+        (wall.maxX - paddle.minX) / paddleVelocity.x,
+        (wall.minX - paddle.maxX) / paddleVelocity.x,
+        (wall.maxY - paddle.minY) / paddleVelocity.y,
+        (wall.minY - paddle.maxY) / paddleVelocity.y
     };
 
     float minValidT = 1;
@@ -131,6 +178,7 @@ void useCollisionSystem<Paddle, Wall>(
     }
 
     paddlePos += paddleVelocity * minValidT;
+    paddle = computeBounds(paddlePos, constWorld.getData<Rectangle>(paddleId));
     world.removeComponent<Velocity>(paddleId);
 }
 
@@ -143,6 +191,7 @@ template void useCollisionSystem<T, U>(\
 
 INSTANTIATE(Ball, Paddle);
 INSTANTIATE(Ball, Brick);
+INSTANTIATE(Ball, TileMap);
 INSTANTIATE(Ball, Wall);
 INSTANTIATE(Paddle, PowerUp);
 INSTANTIATE(Paddle, Wall);
@@ -152,23 +201,27 @@ INSTANTIATE(Paddle, Wall);
 // Helper functions
 // ----------------------------------------------------
 
-template<typename F>
+template<typename T, typename F>
 void handleBounceCollisions(
     ecs::World& world,
     ecs::Entity ballId,
-    const metadata::MultiRectCollisionData& collisions,
+    const std::pmr::vector<T>& collisions,
     F shouldIgnoreCollisionFn
 ) {
     bool collidesInX = false;
     bool collidesInY = false;
 
-    for (const metadata::RectCollisionData& collisionData : collisions) {
-        if (!shouldIgnoreCollisionFn(world, ballId, collisionData.objectId)) {
+    for (const T& collisionData : collisions) {
+        if (!shouldIgnoreCollisionFn(world, ballId, collisionData)) {
             collidesInX = collidesInX || collisionData.collidesInX;
             collidesInY = collidesInY || collisionData.collidesInY;
         }
     }
 
+    if (!collidesInX && !collidesInY) {
+        return;
+    }
+
     Velocity& ballVelocity = world.getData<Velocity>(ballId);
 
     if (collidesInX) {
@@ -185,30 +238,41 @@ bool handleBallBrickCollision(
     ecs::Entity ballId,
     ecs::Entity brickId
 ) {
-    std::cout << "Collision detected with brick " << brickId << '\n';
+    LOG_DEBUG("Collision detected with brick {}", brickId);
 
     if (world.hasComponent<PiercingBall>(ballId)) {
         world.deleteEntity(brickId);
         return true;
     }
 
-    if (misc::checkPercentage(50)) {
-        using constants::POWERUP_RADIUS;
-        using constants::POWERUP_VELOCITY;
+    if (shouldDropPowerUp(world)) {
+        const ecs::World& constWorld = world;
+        spawnPowerUp(world, constWorld.getData<Position>(brickId));
+    }
+
+    world.deleteEntity(brickId);
+    return false;
+}
+
+bool handleBallTileCollision(
+    ecs::World& world,
+    ecs::Entity ballId,
+    const metadata::TileCollisionData& collisionData
+) {
+    unsigned cellIndex = collisionData.cellIndex;
+    LOG_DEBUG("Collision detected with tile {}", cellIndex);
+
+    TileMap& tileMap = world.getData<TileMap>(collisionData.tileMapId);
 
-        const Position& brickPos = world.getData<Position>(brickId);
+    if (world.hasComponent<PiercingBall>(ballId)) {
+        tileMap.clearCell(cellIndex);
+        return true;
+    }
 
-        world.createEntity(
-            Circle { POWERUP_RADIUS },
-            brickPos,
-            PowerUp { },
-            Style { sf::Color::Red, sf::Color::Blue, 2 },
-            Velocity { 0, POWERUP_VELOCITY },
-            Visible { }
-        );
+    if (tileMap.hit(cellIndex) && shouldDropPowerUp(world)) {
+        spawnPowerUp(world, tileMap.cellCenter(cellIndex));
     }
 
-    world.deleteEntity(brickId);
     return false;
 }
 
@@ -217,6 +281,30 @@ bool handleBallWallCollision(
     ecs::Entity ballId,
     ecs::Entity wallId
 ) {
-    std::cout << "Collision detected with wall " << wallId << '\n';
+    LOG_DEBUG("Collision detected with wall {}", wallId);
     return false;
 }
+
+bool shouldDropPowerUp(ecs::World& world) {
+    const ecs::World& constWorld = world;
+    const LevelConfig& level = constWorld.getData<LevelConfig>(world.unique<LevelConfig>());
+    return misc::checkPercentage(world.randomEngine(), level.powerUpDropRate);
+}
+
+void spawnPowerUp(ecs::World& world, const Position& position) {
+    using constants::POWERUP_RADIUS;
+    using constants::POWERUP_VELOCITY;
+
+    Circle body { POWERUP_RADIUS };
+
+    world.createEntity(
+        body,
+        computeBounds(position, body),
+        Position { position },
+        PowerUp { },
+        PreviousPosition { position.x, position.y },
+        Style { sf::Color::Red, sf::Color::Blue, 2 },
+        Velocity { 0, POWERUP_VELOCITY },
+        Visible { }
+    );
+}
@@ -1,78 +1,93 @@
 #include "include.hpp"
 
 #include <algorithm>
+#include <type_traits>
+#include <utility>
 #include "../../helpers/aggregate-data.hpp"
+#include "../../helpers/bounds.hpp"
 
 static void detectBallCollisions(ecs::World&, float);
 static void detectBallPaddleCollisions(
     ecs::World&,
     ecs::Entity,
-    const CircleData&,
-    const CircleData&
+    const SweptCircleData&
 );
 static void detectBounceCollisions(
     ecs::World&,
     ecs::Entity,
-    const CircleData&,
-    const CircleData&
+    const SweptCircleData&
 );
 static void detectPaddleCollisions(ecs::World&, float);
-static void detectPaddlePowerUpCollisions(ecs::World&, ecs::Entity, const RectangleData&);
+static void detectPaddlePowerUpCollisions(ecs::World&, ecs::Entity, const Bounds&);
 static void detectPaddleWallCollisions(
     ecs::World&,
     ecs::Entity,
-    const RectangleData&,
+    const Bounds&,
     const Velocity&
 );
-static bool collides(const CircleData&, const RectangleData&);
-static bool collides(const RectangleData&, const Velocity&, const RectangleData&);
+static bool collides(const CircleData&, const Bounds&);
+static bool collides(const Bounds&, const Velocity&, const Bounds&);
+template<typename T>
+static void sortCollisions(std::pmr::vector<T>&);
 
 void useCollisionSystem(ecs::World& world, float elapsedTime) {
+    PROFILE_SYSTEM("useCollisionSystem");
+
     detectBallCollisions(world, elapsedTime);
     detectPaddleCollisions(world, elapsedTime);
 }
 
 void detectBallCollisions(ecs::World& world, float elapsedTime) {
+    // Balls and collisions are handled in entity order, since handling them
+    // changes the world, e.g the first ball to reach a brick destroys it
     world.findAll<Ball>()
         .join<Circle>()
         .join<Position>()
+        .join<Bounds>()
         .join<Velocity>()
-        .forEach([&world, elapsedTime](
+        .orderedForEach([&world, elapsedTime](
             ecs::Entity ballId,
             const Circle& c,
             const Position& ballPos,
+            const Bounds& ballBounds,
             const Velocity& v
         ) {
             Velocity velocity = v * elapsedTime;
             Position nextPositionX { ballPos.x + velocity.x, ballPos.y };
             Position nextPositionY { ballPos.x, ballPos.y + velocity.y };
-            CircleData nextBallDataX { c, nextPositionX };
-            CircleData nextBallDataY { c, nextPositionY };
 
-            detectBallPaddleCollisions(world, ballId, nextBallDataX, nextBallDataY);
-            detectBounceCollisions(world, ballId, nextBallDataX, nextBallDataY);
+            SweptCircleData ball {
+                { c, nextPositionX },
+                { c, nextPositionY },
+                {
+                    ballBounds.minX + std::min(velocity.x, 0.0f),
+                    ballBounds.minY + std::min(velocity.y, 0.0f),
+                    ballBounds.maxX + std::max(velocity.x, 0.0f),
+                    ballBounds.maxY + std::max(velocity.y, 0.0f)
+                }
+            };
+
+            detectBallPaddleCollisions(world, ballId, ball);
+            detectBounceCollisions(world, ballId, ball);
         });
 }
 
 void detectBallPaddleCollisions(
     ecs::World& world,
     ecs::Entity ballId,
-    const CircleData& nextBallDataX,
-    const CircleData& nextBallDataY
+    const SweptCircleData& ball
 ) {
-    std::vector<ecs::Entity> collidedPaddles;
+    std::pmr::vector<ecs::Entity> collidedPaddles(&world.frameArena());
 
     world.findAll<Paddle>()
-        .join<Rectangle>()
-        .join<Position>()
-        .forEach([&](
-            ecs::Entity paddleId,
-            const Rectangle& r,
-            const Position& paddlePos
-        ) {
-            RectangleData rectangle { r, paddlePos };
-            bool collidesInX = collides(nextBallDataX, rectangle);
-            bool collidesInY = collides(nextBallDataY, rectangle);
+        .join<Bounds>()
+        .forEach([&](ecs::Entity paddleId, const Bounds& paddleBounds) {
+            if (!overlaps(ball.sweptBounds, paddleBounds)) {
+                return;
+            }
+
+            bool collidesInX = collides(ball.nextX, paddleBounds);
+            bool collidesInY = collides(ball.nextY, paddleBounds);
 
             if (collidesInX || collidesInY) {
                 collidedPaddles.push_back({ paddleId });
@@ -80,6 +95,7 @@ void detectBallPaddleCollisions(
         });
 
     if (!collidedPaddles.empty()) {
+        sortCollisions(collidedPaddles);
         world.notify<CollisionListener<Ball, Paddle>>(ballId, collidedPaddles);
     }
 }
@@ -87,22 +103,19 @@ void detectBallPaddleCollisions(
 void detectBounceCollisions(
     ecs::World& world,
     ecs::Entity ballId,
-    const CircleData& nextBallDataX,
-    const CircleData& nextBallDataY
+    const SweptCircleData& ball
 ) {
-    std::vector<metadata::RectCollisionData> collidedBricks;
+    std::pmr::vector<metadata::RectCollisionData> collidedBricks(&world.frameArena());
 
     world.findAll<Brick>()
-        .join<Rectangle>()
-        .join<Position>()
-        .forEach([&world, &collidedBricks, &nextBallDataX, &nextBallDataY](
-            ecs::Entity objectId,
-            const Rectangle& r,
-            const Position& rectPos
-        ) {
-            RectangleData rectangle { r, rectPos };
-            bool collidesInX = collides(nextBallDataX, rectangle);
-            bool collidesInY = collides(nextBallDataY, rectangle);
+        .join<Bounds>()
+        .forEach([&ball, &collidedBricks](ecs::Entity objectId, const Bounds& rect) {
+            if (!overlaps(ball.sweptBounds, rect)) {
+                return;
+            }
+
+            bool collidesInX = collides(ball.nextX, rect);
+            bool collidesInY = collides(ball.nextY, rect);
 
             if (collidesInX || collidesInY) {
                 collidedBricks.push_back({ objectId, collidesInX, collidesInY });
@@ -110,24 +123,63 @@ void detectBounceCollisions(
         });
 
     if (!collidedBricks.empty()) {
+        sortCollisions(collidedBricks);
         world.notify<CollisionListener<Ball, Brick>>(ballId, collidedBricks);
     }
 
 
 
-    std::vector<metadata::RectCollisionData> collidedWalls;
+    std::pmr::vector<metadata::TileCollisionData> collidedTiles(&world.frameArena());
 
-    world.findAll<Wall>()
-        .join<Rectangle>()
-        .join<Position>()
-        .forEach([&world, &collidedWalls, &nextBallDataX, &nextBallDataY](
-            ecs::Entity objectId,
-            const Rectangle& r,
-            const Position& rectPos
+    world.findAll<TileMap>()
+        .join<Bounds>()
+        .forEach([&ball, &collidedTiles](
+            ecs::Entity tileMapId,
+            const TileMap& tileMap,
+            const Bounds& tileMapBounds
         ) {
-            RectangleData rectangle { r, rectPos };
-            bool collidesInX = collides(nextBallDataX, rectangle);
-            bool collidesInY = collides(nextBallDataY, rectangle);
+            const Bounds& swept = ball.sweptBounds;
+
+            if (!overlaps(swept, tileMapBounds)) {
+                return;
+            }
+
+            tileMap.forEachSolidCellIn(
+                swept.minX,
+                swept.minY,
+                swept.maxX,
+                swept.maxY,
+                [&](unsigned cellIndex) {
+                    Rectangle cellBody { tileMap.cellWidth, tileMap.cellHeight };
+                    Bounds cell = computeBounds(tileMap.cellCenter(cellIndex), cellBody);
+                    bool collidesInX = collides(ball.nextX, cell);
+                    bool collidesInY = collides(ball.nextY, cell);
+
+                    if (collidesInX || collidesInY) {
+                        collidedTiles.push_back({ tileMapId, cellIndex, collidesInX, collidesInY });
+                    }
+                }
+            );
+        });
+
+    if (!collidedTiles.empty()) {
+        sortCollisions(collidedTiles);
+        world.notify<CollisionListener<Ball, TileMap>>(ballId, collidedTiles);
+    }
+
+
+
+    std::pmr::vector<metadata::RectCollisionData> collidedWalls(&world.frameArena());
+
+    world.findAll<Wall>()
+        .join<Bounds>()
+        .forEach([&ball, &collidedWalls](ecs::Entity objectId, const Bounds& rect) {
+            if (!overlaps(ball.sweptBounds, rect)) {
+                return;
+            }
+
+            bool collidesInX = collides(ball.nextX, rect);
+            bool collidesInY = collides(ball.nextY, rect);
 
             if (collidesInX || collidesInY) {
                 collidedWalls.push_back({ objectId, collidesInX, collidesInY });
@@ -135,25 +187,21 @@ void detectBounceCollisions(
         });
 
     if (!collidedWalls.empty()) {
+        sortCollisions(collidedWalls);
         world.notify<CollisionListener<Ball, Wall>>(ballId, collidedWalls);
     }
 }
 
 void detectPaddleCollisions(ecs::World& world, float elapsedTime) {
-    world.findAll<Paddle>()
-        .join<Rectangle>()
-        .join<Position>()
-        .forEach([&world, elapsedTime](
-            ecs::Entity paddleId,
-            const Rectangle& paddleBody,
-            const Position& paddlePos
-        ) {
-            RectangleData paddle { paddleBody, paddlePos };
+    const ecs::World& constWorld = world;
 
+    world.findAll<Paddle>()
+        .join<Bounds>()
+        .orderedForEach([&world, &constWorld, elapsedTime](ecs::Entity paddleId, const Bounds& paddle) {
             detectPaddlePowerUpCollisions(world, paddleId, paddle);
 
             if (world.hasComponent<Velocity>(paddleId)) {
-                const Velocity& v = world.getData<Velocity>(paddleId);
+                const Velocity& v = constWorld.getData<Velocity>(paddleId);
                 Velocity paddleVelocity = v * elapsedTime;
 
                 detectPaddleWallCollisions(world, paddleId, paddle, paddleVelocity);
@@ -164,20 +212,24 @@ void detectPaddleCollisions(ecs::World& world, float elapsedTime) {
 void detectPaddlePowerUpCollisions(
     ecs::World& world,
     ecs::Entity paddleId,
-    const RectangleData& paddle
+    const Bounds& paddle
 ) {
-    std::vector<ecs::Entity> collidedPowerUps;
+    std::pmr::vector<ecs::Entity> collidedPowerUps(&world.frameArena());
 
     world.findAll<PowerUp>()
         .join<Circle>()
         .join<Position>()
-        .join<Velocity>()
-        .forEach([&world, paddleId, &paddle, &collidedPowerUps](
+        .join<Bounds>()
+        .forEach([&paddle, &collidedPowerUps](
             ecs::Entity powerUpId,
             const Circle& powerUpBody,
             const Position& powerUpPos,
-            const Velocity& powerUpVelocity
+            const Bounds& powerUpBounds
         ) {
+            if (!overlaps(powerUpBounds, paddle)) {
+                return;
+            }
+
             CircleData powerUp { powerUpBody, powerUpPos };
 
             if (collides(powerUp, paddle)) {
@@ -186,6 +238,7 @@ void detectPaddlePowerUpCollisions(
         });
 
     if (!collidedPowerUps.empty()) {
+        sortCollisions(collidedPowerUps);
         world.notify<CollisionListener<Paddle, PowerUp>>(paddleId, collidedPowerUps);
     }
 }
@@ -193,42 +246,33 @@ void detectPaddlePowerUpCollisions(
 void detectPaddleWallCollisions(
     ecs::World& world,
     ecs::Entity paddleId,
-    const RectangleData& paddle,
+    const Bounds& paddle,
     const Velocity& paddleVelocity
 ) {
-    std::vector<ecs::Entity> collidedWalls;
+    std::pmr::vector<ecs::Entity> collidedWalls(&world.frameArena());
 
     world.findAll<Wall>()
-        .join<Rectangle>()
-        .join<Position>()
-        .forEach([&world, &paddleId, &paddle, &paddleVelocity, &collidedWalls](
+        .join<Bounds>()
+        .forEach([&paddle, &paddleVelocity, &collidedWalls](
             ecs::Entity wallId,
-            const Rectangle& r,
-            const Position& rectPos
+            const Bounds& wall
         ) {
-            RectangleData wall { r, rectPos };
-
             if (collides(paddle, paddleVelocity, wall)) {
                 collidedWalls.push_back({ wallId });
             }
         });
 
     if (!collidedWalls.empty()) {
+        sortCollisions(collidedWalls);
         world.notify<CollisionListener<Paddle, Wall>>(paddleId, collidedWalls);
     }
 }
 
-bool collides(const CircleData& c, const RectangleData& r) {
+bool collides(const CircleData& c, const Bounds& rect) {
     const auto& [circle, circlePos] = c;
-    const auto& [rectangle, rectPos] = r;
-
-    float rectLeftX = rectPos.x - rectangle.width / 2;
-    float rectRightX = rectPos.x + rectangle.width / 2;
-    float rectTopY = rectPos.y - rectangle.height / 2;
-    float rectBottomY = rectPos.y + rectangle.height / 2;
 
-    float closestX = std::clamp(circlePos.x, rectLeftX, rectRightX);
-    float closestY = std::clamp(circlePos.y, rectTopY, rectBottomY);
+    float closestX = std::clamp(circlePos.x, rect.minX, rect.maxX);
+    float closestY = std::clamp(circlePos.y, rect.minY, rect.maxY);
 
     float dx = circlePos.x - closestX;
     float dy = circlePos.y - closestY;
@@ -237,14 +281,31 @@ bool collides(const CircleData& c, const RectangleData& r) {
 }
 
 bool collides(
-    const RectangleData& paddle,
+    const Bounds& paddle,
     const Velocity& paddleVelocity,
-    const RectangleData& wall
+    const Bounds& wall
 ) {
-    bool checkLeft = (wall.rightX() - paddle.leftX()) > paddleVelocity.x;
-    bool checkRight = paddleVelocity.x > (wall.leftX() - paddle.rightX());
-    bool checkTop = (wall.bottomY() - paddle.topY()) > paddleVelocity.y;
-    bool checkBottom = paddleVelocity.y > (wall.topY() - paddle.bottomY());
+    bool checkLeft = (wall.maxX - paddle.minX) > paddleVelocity.x;
+    bool checkRight = paddleVelocity.x > (wall.minX - paddle.maxX);
+    bool checkTop = (wall.maxY - paddle.minY) > paddleVelocity.y;
+    bool checkBottom = paddleVelocity.y > (wall.minY - paddle.maxY);
 
     return checkLeft && checkRight && checkTop && checkBottom;
 }
+
+template<typename T>
+void sortCollisions(std::pmr::vector<T>& collisions) {
+    auto key = [](const T& collision) {
+        if constexpr (std::is_same_v<T, metadata::RectCollisionData>) {
+            return std::make_pair(collision.objectId, 0u);
+        } else if constexpr (std::is_same_v<T, metadata::TileCollisionData>) {
+            return std::make_pair(collision.tileMapId, collision.cellIndex);
+        } else {
+            return std::make_pair(collision, 0u);
+        }
+    };
+
+    std::sort(collisions.begin(), collisions.end(), [&key](const T& lhs, const T& rhs) {
+        return key(lhs) < key(rhs);
+    });
+}
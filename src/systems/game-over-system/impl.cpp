@@ -1,17 +1,17 @@
 #include "include.hpp"
 
-#include "../../constants.hpp"
-
 void useGameOverSystem(ecs::World& world) {
+    PROFILE_SYSTEM("useGameOverSystem");
+
+    const ecs::World& constWorld = world;
     bool hasBallsInPlay = false;
+    float boardHeight = constWorld.getData<LevelConfig>(world.unique<LevelConfig>()).boardHeight;
 
     world.findAll<Ball>()
         .join<Position>()
         .mutatingForEach(
-            [&world, &hasBallsInPlay](ecs::Entity ballId, Position& pos) {
-                using constants::WINDOW_HEIGHT;
-
-                if (pos.y >= WINDOW_HEIGHT) {
+            [&world, &hasBallsInPlay, boardHeight](ecs::Entity ballId, const Position& pos) {
+                if (pos.y >= boardHeight) {
                     world.deleteEntity(ballId);
                 } else {
                     hasBallsInPlay = true;
@@ -1,25 +1,44 @@
 #include "include.hpp"
 
-#include <SFML/Graphics.hpp>
 #include "../../constants.hpp"
 
-void useInputSystem(ecs::World& world) {
+void useInputSystem(ecs::World& world, const Controls& controls) {
+    PROFILE_SYSTEM("useInputSystem");
+
+    using constants::PADDLE_VELOCITY;
+
+    float direction = controls.left ? -1 : (controls.right ? 1 : 0);
+
+    if (controls.travel) {
+        direction = static_cast<float>(*controls.travel) / Controls::TRAVEL_STEPS;
+    }
+
+    Velocity velocity { direction * PADDLE_VELOCITY, 0 };
+    const ecs::World& constWorld = world;
+
+    // The velocity is only written when it changes, so that idle or steadily
+    // moving paddles don't churn components (nor snapshot chunks)
     world.findAll<Input>()
         .forEach(
-            [&world](ecs::Entity id) {
-                using constants::PADDLE_VELOCITY;
+            [&world, &constWorld, &velocity, direction](ecs::Entity id) {
+                bool moving = world.hasComponent<Velocity>(id);
 
-                Velocity velocity;
+                if (direction == 0) {
+                    if (moving) {
+                        world.removeComponent<Velocity>(id);
+                    }
 
-                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) {
-                    velocity = { -PADDLE_VELOCITY, 0 };
-                } else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) {
-                    velocity = { PADDLE_VELOCITY, 0 };
-                } else {
-                    world.removeComponent<Velocity>(id);
                     return;
                 }
 
+                if (moving) {
+                    const Velocity& current = constWorld.getData<Velocity>(id);
+
+                    if (current.x == velocity.x && current.y == velocity.y) {
+                        return;
+                    }
+                }
+
                 world.replaceComponent(id, velocity);
             }
         );
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../../Controls.hpp"
 #include "../../engine-glue/ecs.hpp"
 
-void useInputSystem(ecs::World&);
+void useInputSystem(ecs::World&, const Controls&);
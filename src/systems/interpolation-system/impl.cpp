@@ -0,0 +1,14 @@
+#include "include.hpp"
+
+void useInterpolationSystem(ecs::World& world) {
+    PROFILE_SYSTEM("useInterpolationSystem");
+
+    world.findAll<PreviousPosition>()
+        .join<Position>()
+        .forEach(
+            [](PreviousPosition& previousPos, const Position& pos) {
+                previousPos.x = pos.x;
+                previousPos.y = pos.y;
+            }
+        );
+}
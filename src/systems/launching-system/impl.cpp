@@ -3,8 +3,11 @@
 #include "../../helpers/ball-paddle-contact.hpp"
 
 void useLaunchingSystem(ecs::World& world) {
+    PROFILE_SYSTEM("useLaunchingSystem");
+
+    const ecs::World& constWorld = world;
     ecs::Entity paddleId = world.unique<Paddle>();
-    const Position& paddlePos = world.getData<Position>(paddleId);
+    const Position& paddlePos = constWorld.getData<Position>(paddleId);
 
     world.findAll<Ball>()
         .join<Position>()
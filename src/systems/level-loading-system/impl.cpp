@@ -1,138 +1,397 @@
 #include "include.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <random>
 #include "../../constants.hpp"
+#include "../../helpers/bounds.hpp"
+#include "../../LevelFile.hpp"
 
-static void createPaddle(ecs::World& world);
-static void createBall(ecs::World& world);
-static void createBricks(ecs::World& world);
-static void createWalls(ecs::World& world);
+static void createLevel(ecs::World&, const LevelConfig&);
+static void createPaddle(ecs::World&, const LevelConfig&);
+static void createBalls(ecs::World&, const LevelConfig&);
+static void createBricks(ecs::World&, const LevelConfig&);
+static void ingestLevelFile(ecs::World&, const LevelFile&);
+static void addTags(ecs::World&, ecs::Entity first, const LevelFile&);
+static TileMap createBrickGrid(const LevelConfig&, float density);
+static void fillGrid(TileMap&, unsigned brickCount);
+static void fillClusters(ecs::World&, TileMap&, unsigned brickCount);
+static void scatterBricks(ecs::World&, const LevelConfig&);
+static float getBrickScale(const LevelConfig&, float density);
+static void createWalls(ecs::World&, const LevelConfig&);
+static void createWall(ecs::World&, const Position&, const Rectangle&, const Style&);
+static void createStaticLayer(ecs::World& world);
+static void createTimerQueue(ecs::World& world);
 
-void useLevelLoadingSystem(ecs::World& world) {
-    createPaddle(world);
-    createBall(world);
-    createBricks(world);
-    createWalls(world);
+// Top of the area where bricks are placed, which spans 40% of the board
+constexpr float BRICK_AREA_TOP = 100;
+constexpr float BRICK_AREA_HEIGHT_RATIO = 0.4;
+
+void useLevelLoadingSystem(ecs::World& world, const LevelConfig& level) {
+    PROFILE_SYSTEM("useLevelLoadingSystem");
+
+    if (!level.file.empty()) {
+        LevelFile file(level.file);
+        LevelConfig fileLevel = file.config();
+
+        createLevel(world, fileLevel);
+        createPaddle(world, fileLevel);
+        createBalls(world, fileLevel);
+        ingestLevelFile(world, file);
+    } else {
+        createLevel(world, level);
+        createPaddle(world, level);
+        createBalls(world, level);
+        createBricks(world, level);
+        createWalls(world, level);
+    }
+
+    createStaticLayer(world);
+    createTimerQueue(world);
+}
+
+void createLevel(ecs::World& world, const LevelConfig& level) {
+    world.createEntity(LevelConfig(level));
 }
 
-void createPaddle(ecs::World& world) {
-    using constants::WINDOW_WIDTH;
-    using constants::WINDOW_HEIGHT;
+void createPaddle(ecs::World& world, const LevelConfig& level) {
     using constants::PADDLE_WIDTH;
     using constants::PADDLE_HEIGHT;
     using constants::PADDLE_BORDER_DISTANCE;
 
-    constexpr float x = WINDOW_WIDTH / 2;
-    constexpr float y = WINDOW_HEIGHT - PADDLE_BORDER_DISTANCE - PADDLE_HEIGHT / 2;
+    float x = level.boardWidth / 2;
+    float y = level.boardHeight - PADDLE_BORDER_DISTANCE - PADDLE_HEIGHT / 2;
+
+    Position position { x, y };
+    Rectangle body { PADDLE_WIDTH, PADDLE_HEIGHT };
 
     world.createEntity(
+        computeBounds(position, body),
         Input { },
         Paddle { },
-        Position { x, y },
-        Rectangle { PADDLE_WIDTH, PADDLE_HEIGHT },
+        position,
+        PreviousPosition { x, y },
+        body,
         Style { sf::Color::White, sf::Color::Blue, 1 },
         Visible { }
     );
 }
 
-void createBall(ecs::World& world) {
-    using constants::WINDOW_WIDTH;
-    using constants::WINDOW_HEIGHT;
+void createBalls(ecs::World& world, const LevelConfig& level) {
     using constants::BALL_RADIUS;
+    using constants::PADDLE_WIDTH;
     using constants::PADDLE_HEIGHT;
     using constants::PADDLE_BORDER_DISTANCE;
 
-    constexpr float x = WINDOW_WIDTH / 2;
-    constexpr float y = WINDOW_HEIGHT - PADDLE_BORDER_DISTANCE - PADDLE_HEIGHT - BALL_RADIUS;
+    // Balls are spread evenly over the paddle
+    float spacing = PADDLE_WIDTH / level.ballCount;
+    float firstX = level.boardWidth / 2 - PADDLE_WIDTH / 2 + spacing / 2;
+    float y = level.boardHeight - PADDLE_BORDER_DISTANCE - PADDLE_HEIGHT - BALL_RADIUS;
+
+    for (unsigned i = 0; i < level.ballCount; i++) {
+        Position position { firstX + i * spacing, y };
+        Circle body { BALL_RADIUS };
+
+        world.createEntity(
+            Ball { },
+            computeBounds(position, body),
+            body,
+            position,
+            PreviousPosition { position.x, position.y },
+            Style { sf::Color::Blue, sf::Color::Green, 2 },
+            Visible { }
+        );
+    }
+}
+
+void createBricks(ecs::World& world, const LevelConfig& level) {
+    if (level.layout == BrickLayout::Scatter) {
+        scatterBricks(world, level);
+        return;
+    }
+
+    bool isGrid = (level.layout == BrickLayout::Grid);
+    TileMap bricks = createBrickGrid(level, isGrid ? 1 : 0.5);
+
+    if (isGrid) {
+        fillGrid(bricks, level.brickCount);
+    } else {
+        fillClusters(world, bricks, level.brickCount);
+    }
 
     world.createEntity(
-        Ball { },
-        Circle { BALL_RADIUS },
-        Position { x, y },
-        Style { sf::Color::Blue, sf::Color::Green, 2 },
+        BounceCollision { },
+        computeBounds(bricks),
+        std::move(bricks),
         Visible { }
     );
 }
 
-void createBricks(ecs::World& world) {
-    using constants::WINDOW_WIDTH;
+/**
+ * Creates the bricks and walls of a level file. Each component column is
+ * copied as a whole into the storage of the world, and Bounds are derived
+ * in a single pass over the Position and Rectangle columns.
+ */
+void ingestLevelFile(ecs::World& world, const LevelFile& file) {
+    if (file.hasTileMap()) {
+        TileMap bricks = file.tileMap();
+
+        world.createEntity(
+            BounceCollision { },
+            computeBounds(bricks),
+            std::move(bricks),
+            Visible { }
+        );
+    }
+
+    std::size_t count = file.entityCount();
+    ecs::Entity first = world.createEntities(count);
+    const Position* positions = file.positions();
+    const Rectangle* rectangles = file.rectangles();
+
+    world.addComponents(first, positions, count);
+    world.addComponents(first, rectangles, count);
+    world.addComponents(first, file.styles(), count);
+
+    world.reserve<Bounds>(world.count<Bounds>() + count);
+    for (std::size_t i = 0; i < count; i++) {
+        world.addComponent(first + i, computeBounds(positions[i], rectangles[i]));
+    }
+
+    addTags(world, first, file);
+}
+
+void addTags(ecs::World& world, ecs::Entity first, const LevelFile& file) {
+    std::size_t count = file.entityCount();
+    const std::uint8_t* tags = file.tags();
+
+    world.reserve<Brick>(world.count<Brick>() + count);
+    world.reserve<Visible>(world.count<Visible>() + count);
+
+    for (std::size_t i = 0; i < count; i++) {
+        ecs::Entity entity = first + i;
+
+        if (tags[i] & LevelFile::BOUNCE_COLLISION) {
+            world.addComponent(entity, BounceCollision { });
+        }
+
+        if (tags[i] & LevelFile::BRICK) {
+            world.addComponent(entity, Brick { });
+        }
+
+        if (tags[i] & LevelFile::VISIBLE) {
+            world.addComponent(entity, Visible { });
+        }
+
+        if (tags[i] & LevelFile::WALL) {
+            world.addComponent(entity, Wall { });
+        }
+    }
+}
+
+/**
+ * Creates an empty tile map over the brick area, with enough cells for
+ * `brickCount` bricks to cover `density` of them.
+ */
+TileMap createBrickGrid(const LevelConfig& level, float density) {
     using constants::BRICK_WIDTH;
     using constants::BRICK_HEIGHT;
     using constants::BOARD_BORDER;
 
-    constexpr float MAX_X = WINDOW_WIDTH - BOARD_BORDER;
-    constexpr int BRICKS_PER_ROW = (MAX_X - BOARD_BORDER) / BRICK_WIDTH;
+    float scale = getBrickScale(level, density);
+    float cellWidth = BRICK_WIDTH * scale;
+    float cellHeight = BRICK_HEIGHT * scale;
 
-    std::array<Style, 6> styles {
-        Style { sf::Color::White, sf::Color::Blue, 1 },
-        Style { sf::Color::Green, sf::Color::Blue, 1 },
-        Style { sf::Color::White, sf::Color::Blue, 1 },
-        Style { sf::Color::Green, sf::Color::Blue, 1 },
-        Style { sf::Color::White, sf::Color::Blue, 1 },
-        Style { sf::Color::Green, sf::Color::Blue, 1 }
+    float areaWidth = level.boardWidth - 2 * BOARD_BORDER;
+    unsigned columns = std::max(1.0f, std::floor(areaWidth / cellWidth));
+    unsigned cellCount = std::ceil(level.brickCount / density);
+    unsigned rows = std::max(1u, (cellCount + columns - 1) / columns);
+
+    TileMap bricks {
+        Position { BOARD_BORDER, BRICK_AREA_TOP },
+        cellWidth,
+        cellHeight,
+        columns,
+        rows,
+        {
+            Style { sf::Color::White, sf::Color::Blue, 1 },
+            Style { sf::Color::Green, sf::Color::Blue, 1 }
+        },
+        { }
     };
 
-    for (int i = 0; i < BRICKS_PER_ROW; i++) {
-        float x = BOARD_BORDER + i * BRICK_WIDTH + BRICK_WIDTH / 2;
+    bricks.cells.assign(columns * rows, TileCell { 0, 0 });
+    return bricks;
+}
+
+void fillGrid(TileMap& bricks, unsigned brickCount) {
+    for (unsigned i = 0; i < brickCount && i < bricks.cells.size(); i++) {
+        std::uint8_t style = (i / bricks.columns) % 2;
+        bricks.cells[i] = TileCell { style, 1 };
+    }
+}
+
+/**
+ * Paints round clusters of random sizes at random places until there
+ * are `brickCount` bricks. Each cluster alternates the style.
+ */
+void fillClusters(ecs::World& world, TileMap& bricks, unsigned brickCount) {
+    std::mt19937& random = world.randomEngine();
+    std::uniform_int_distribution<unsigned> column(0, bricks.columns - 1);
+    std::uniform_int_distribution<unsigned> row(0, bricks.rows - 1);
+    std::uniform_real_distribution<float> radius(1, std::max(2.0, std::sqrt(brickCount) / 4));
 
-        for (int j = 0; j < 6; j++) {
-            float y = 100 + j * BRICK_HEIGHT + BRICK_HEIGHT / 2;
+    brickCount = std::min<std::size_t>(brickCount, bricks.cells.size());
+    unsigned placed = 0;
+    std::uint8_t style = 0;
 
-            world.createEntity(
-                BounceCollision { },
-                Brick { },
-                Position { x, y },
-                Rectangle { BRICK_WIDTH, BRICK_HEIGHT },
-                styles[j],
-                Visible { }
-            );
+    while (placed < brickCount) {
+        int centerColumn = column(random);
+        int centerRow = row(random);
+        float r = radius(random);
+        int extent = r;
+
+        for (int dy = -extent; dy <= extent && placed < brickCount; dy++) {
+            for (int dx = -extent; dx <= extent && placed < brickCount; dx++) {
+                int c = centerColumn + dx;
+                int j = centerRow + dy;
+
+                bool inside = c >= 0 && j >= 0
+                    && c < static_cast<int>(bricks.columns)
+                    && j < static_cast<int>(bricks.rows)
+                    && dx * dx + dy * dy <= r * r;
+
+                if (inside && !bricks.isSolid(bricks.indexOf(c, j))) {
+                    bricks.cells[bricks.indexOf(c, j)] = TileCell { style, 1 };
+                    placed++;
+                }
+            }
         }
+
+        style = 1 - style;
     }
 }
 
-void createWalls(ecs::World& world) {
-    using constants::WINDOW_WIDTH;
-    using constants::WINDOW_HEIGHT;
+/**
+ * Creates one entity per brick at random, possibly overlapping, positions
+ * of the brick area, which exercises the per-entity collision path.
+ */
+void scatterBricks(ecs::World& world, const LevelConfig& level) {
+    using constants::BRICK_WIDTH;
+    using constants::BRICK_HEIGHT;
+    using constants::BOARD_BORDER;
+
+    float scale = getBrickScale(level, 0.5);
+    Rectangle body { BRICK_WIDTH * scale, BRICK_HEIGHT * scale };
+
+    float areaHeight = level.boardHeight * BRICK_AREA_HEIGHT_RATIO;
+    std::mt19937& random = world.randomEngine();
+    std::uniform_real_distribution<float> x(
+        BOARD_BORDER + body.width / 2,
+        level.boardWidth - BOARD_BORDER - body.width / 2
+    );
+    std::uniform_real_distribution<float> y(
+        BRICK_AREA_TOP + body.height / 2,
+        BRICK_AREA_TOP + areaHeight - body.height / 2
+    );
+
+    Style styles[] = {
+        Style { sf::Color::White, sf::Color::Blue, 1 },
+        Style { sf::Color::Green, sf::Color::Blue, 1 }
+    };
+
+    for (unsigned i = 0; i < level.brickCount; i++) {
+        Position position { x(random), y(random) };
+
+        world.createEntity(
+            computeBounds(position, body),
+            Brick { },
+            position,
+            body,
+            styles[i % 2],
+            Visible { }
+        );
+    }
+}
+
+/**
+ * Returns how much bricks must shrink, relative to the classic size, so
+ * that `brickCount` of them cover `density` of the brick area.
+ */
+float getBrickScale(const LevelConfig& level, float density) {
+    using constants::BRICK_WIDTH;
+    using constants::BRICK_HEIGHT;
+    using constants::BOARD_BORDER;
+
+    float areaWidth = level.boardWidth - 2 * BOARD_BORDER;
+    float areaHeight = level.boardHeight * BRICK_AREA_HEIGHT_RATIO;
+    float neededArea = level.brickCount / density * BRICK_WIDTH * BRICK_HEIGHT;
+
+    return std::min(1.0f, std::sqrt(areaWidth * areaHeight / neededArea));
+}
+
+void createWalls(ecs::World& world, const LevelConfig& level) {
     using constants::BOARD_BORDER;
 
+    float width = level.boardWidth;
+    float height = level.boardHeight;
+
     Style style { sf::Color::White, sf::Color::White, 1 };
 
     // Top
-    world.createEntity(
-        BounceCollision { },
-        Position { WINDOW_WIDTH / 2, BOARD_BORDER / 2 },
-        Rectangle { WINDOW_WIDTH, BOARD_BORDER },
-        style,
-        Visible { },
-        Wall { }
+    createWall(
+        world,
+        Position { width / 2, BOARD_BORDER / 2 },
+        Rectangle { width, BOARD_BORDER },
+        style
     );
 
     // Left
-    world.createEntity(
-        BounceCollision { },
-        Position { BOARD_BORDER / 2, WINDOW_HEIGHT / 2 },
-        Rectangle { BOARD_BORDER, WINDOW_HEIGHT },
-        style,
-        Visible { },
-        Wall { }
+    createWall(
+        world,
+        Position { BOARD_BORDER / 2, height / 2 },
+        Rectangle { BOARD_BORDER, height },
+        style
     );
 
     // Right
-    world.createEntity(
-        BounceCollision { },
-        Position { WINDOW_WIDTH - BOARD_BORDER / 2, WINDOW_HEIGHT / 2 },
-        Rectangle { BOARD_BORDER, WINDOW_HEIGHT },
-        style,
-        Visible { },
-        Wall { }
+    createWall(
+        world,
+        Position { width - BOARD_BORDER / 2, height / 2 },
+        Rectangle { BOARD_BORDER, height },
+        style
     );
 
     // Bottom
+    createWall(
+        world,
+        Position { width / 2, 0 },
+        Rectangle { width, BOARD_BORDER },
+        style
+    );
+}
+
+void createWall(
+    ecs::World& world,
+    const Position& position,
+    const Rectangle& body,
+    const Style& style
+) {
     world.createEntity(
         BounceCollision { },
-        Position { WINDOW_WIDTH / 2, 0 },
-        Rectangle { WINDOW_WIDTH, BOARD_BORDER },
+        computeBounds(position, body),
+        position,
+        body,
         style,
         Visible { },
         Wall { }
     );
 }
+
+void createStaticLayer(ecs::World& world) {
+    world.createEntity(StaticLayer { });
+}
+
+void createTimerQueue(ecs::World& world) {
+    world.createEntity(timing::Clock { }, timing::TimerQueue { });
+}
@@ -2,5 +2,4 @@
 
 #include "../../engine-glue/ecs.hpp"
 
-void useLevelLoadingSystem(ecs::World&);
-
+void useLevelLoadingSystem(ecs::World&, const LevelConfig&);
@@ -1,22 +1,72 @@
 #include "include.hpp"
 
+#include <cstddef>
+#include "../../engine/simd/integrate.hpp"
+
+/**
+ * Positions and velocities of up to `SIZE` entities, gathered as separate
+ * coordinate arrays so that they are integrated in SIMD lanes. Batches are
+ * small enough for the gathered components to still be in cache when the
+ * results are written back.
+ */
+struct MovementBatch {
+    static constexpr std::size_t SIZE = 256;
+
+    Position* positions[SIZE];
+    float x[SIZE];
+    float y[SIZE];
+    float vx[SIZE];
+    float vy[SIZE];
+    std::size_t count = 0;
+};
+
+static void integrateBatch(MovementBatch&, float elapsedTime);
+
 void useMovementSystem(ecs::World& world, float elapsedTime) {
+    PROFILE_SYSTEM("useMovementSystem");
+
+    MovementBatch batch;
+
     world.findAll<Position>()
         .join<Velocity>()
         .forEach(
-            [elapsedTime](Position& pos, const Velocity& v) {
-                pos += v * elapsedTime;
+            [&batch, elapsedTime](Position& pos, const Velocity& v) {
+                std::size_t i = batch.count++;
+                batch.positions[i] = &pos;
+                batch.x[i] = pos.x;
+                batch.y[i] = pos.y;
+                batch.vx[i] = v.x;
+                batch.vy[i] = v.y;
+
+                if (batch.count == MovementBatch::SIZE) {
+                    integrateBatch(batch, elapsedTime);
+                }
             }
         );
 
+    integrateBatch(batch, elapsedTime);
+
+    const ecs::World& constWorld = world;
+
     world.findAll<Link>()
         .join<Position>()
         .forEach(
-            [&world](const Link& link, Position& pos) {
+            [&constWorld](const Link& link, Position& pos) {
                 ecs::Entity target = link.target;
-                const Position& targetPos = world.getData<Position>(target);
+                const Position& targetPos = constWorld.getData<Position>(target);
 
                 pos = targetPos + link.relativePosition;
             }
         );
 }
+
+void integrateBatch(MovementBatch& batch, float elapsedTime) {
+    simd::integrate(batch.x, batch.y, batch.vx, batch.vy, batch.count, elapsedTime);
+
+    for (std::size_t i = 0; i < batch.count; i++) {
+        batch.positions[i]->x = batch.x[i];
+        batch.positions[i]->y = batch.y[i];
+    }
+
+    batch.count = 0;
+}
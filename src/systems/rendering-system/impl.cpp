@@ -1,64 +1,350 @@
 #include "include.hpp"
 
+#include <algorithm>
+#include <numeric>
 #include "../../constants.hpp"
 
-static void renderCircles(ecs::World&, sf::RenderWindow&);
-static void renderRectangles(ecs::World&, sf::RenderWindow&);
+static constexpr unsigned ROWS_PER_BATCH = 16;
 
-void useRenderingSystem(ecs::World& world, sf::RenderWindow& window) {
-    renderCircles(world, window);
-    renderRectangles(world, window);
+// Entity batches follow the chunks whose revisions the world tracks
+static constexpr ecs::Entity ENTITIES_PER_BATCH = ecs::SNAPSHOT_CHUNK_SIZE;
+
+static bool isOutdated(ecs::World&, const StaticLayer&);
+static unsigned batchCountOf(const TileMap&);
+static unsigned rowRevisionSum(const TileMap&, unsigned batch);
+static void refreshStaticEntities(ecs::World&, StaticLayer&);
+static void extractStaticEntity(const ecs::World&, ecs::Entity, rendering::Commands&);
+static void refreshTileMaps(ecs::World&, StaticLayer&);
+static void extractTileMapRows(const TileMap&, unsigned, unsigned, rendering::Commands&);
+static void extractStaticLayer(const StaticLayer&, rendering::CommandList&);
+static Position interpolate(const ecs::World&, ecs::Entity, const Position&, float);
+static void extractCircles(ecs::World&, rendering::Commands&, float);
+static void extractRectangles(ecs::World&, rendering::Commands&, float);
+
+void useRenderingSystem(
+    ecs::World& world,
+    rendering::CommandList& commandList,
+    float interpolation
+) {
+    PROFILE_SYSTEM("useRenderingSystem");
+
+    world.findAll<StaticLayer>()
+        .forEach([&world, &commandList](ecs::Entity layerId, const StaticLayer& layer) {
+            // Only takes the layer mutably when it changes, since marking it
+            // changed makes the next snapshot copy it
+            if (isOutdated(world, layer)) {
+                StaticLayer& outdatedLayer = world.getData<StaticLayer>(layerId);
+                refreshStaticEntities(world, outdatedLayer);
+                refreshTileMaps(world, outdatedLayer);
+            }
+
+            extractStaticLayer(layer, commandList);
+        });
+
+    extractCircles(world, commandList.dynamicCommands, interpolation);
+    extractRectangles(world, commandList.dynamicCommands, interpolation);
+}
+
+bool staticlayer::isStatic(const ecs::World& world, ecs::Entity entity) {
+    return world.hasAnyComponent(entity)
+        && !world.hasComponent<Ball>(entity)
+        && !world.hasComponent<Paddle>(entity)
+        && !world.hasComponent<Input>(entity)
+        && !world.hasComponent<Link>(entity)
+        && !world.hasComponent<Velocity>(entity);
+}
+
+/**
+ * Whether the entities of the layer changed since it was built, or it
+ * doesn't match the visible tile maps anymore. Doesn't change anything in
+ * the world.
+ */
+bool isOutdated(ecs::World& world, const StaticLayer& layer) {
+    if (layer.chunkRevisions != world.chunkRevisions()) {
+        return true;
+    }
+
+    for (const auto& [tileMapId, tileMapLayer] : layer.tileMaps) {
+        if (!world.hasAllComponents<TileMap, Visible>(tileMapId)) {
+            return true;
+        }
+    }
+
+    bool outdated = false;
+
+    world.findAll<Visible>()
+        .join<TileMap>()
+        .forEach([&layer, &outdated](ecs::Entity tileMapId, const TileMap& tileMap) {
+            auto it = layer.tileMaps.find(tileMapId);
+            unsigned batchCount = batchCountOf(tileMap);
+
+            if (it == layer.tileMaps.end() || it->second.batches.size() != batchCount) {
+                outdated = true;
+                return;
+            }
+
+            for (unsigned i = 0; i < batchCount && !outdated; i++) {
+                outdated = it->second.rowRevisionSums[i] != rowRevisionSum(tileMap, i);
+            }
+        });
+
+    return outdated;
+}
+
+unsigned batchCountOf(const TileMap& tileMap) {
+    return (tileMap.rows + ROWS_PER_BATCH - 1) / ROWS_PER_BATCH;
+}
+
+/**
+ * Row revisions only grow, so their sum changes whenever any of them does.
+ * The +1 forces the first build of the batch.
+ */
+unsigned rowRevisionSum(const TileMap& tileMap, unsigned batch) {
+    unsigned firstRow = batch * ROWS_PER_BATCH;
+    unsigned lastRow = std::min(firstRow + ROWS_PER_BATCH, tileMap.rows);
+
+    return std::accumulate(
+        tileMap.rowRevisions.begin() + firstRow,
+        tileMap.rowRevisions.begin() + lastRow,
+        1u
+    );
+}
+
+/**
+ * Rebuilds the batches of the chunks whose revision differs from the one
+ * they were built from, including chunks that are new to the layer.
+ */
+void refreshStaticEntities(ecs::World& world, StaticLayer& layer) {
+    const std::vector<std::uint32_t>& revisions = world.chunkRevisions();
+
+    for (ecs::Entity range = 0; range < revisions.size(); range++) {
+        if (range < layer.chunkRevisions.size() && layer.chunkRevisions[range] == revisions[range]) {
+            continue;
+        }
+
+        auto commands = std::make_shared<rendering::Commands>();
+        ecs::Entity first = range * ENTITIES_PER_BATCH;
+
+        for (ecs::Entity entity = first; entity < first + ENTITIES_PER_BATCH; entity++) {
+            extractStaticEntity(world, entity, *commands);
+        }
+
+        if (commands->empty()) {
+            layer.entityBatches.erase(range);
+        } else {
+            layer.entityBatches[range] = { range, rendering::nextRevision(), std::move(commands) };
+        }
+    }
+
+    // The world may have shrunk, e.g when restored to an older snapshot
+    layer.entityBatches.erase(layer.entityBatches.lower_bound(revisions.size()), layer.entityBatches.end());
+    layer.chunkRevisions = revisions;
+}
+
+void extractStaticEntity(
+    const ecs::World& world,
+    ecs::Entity entity,
+    rendering::Commands& commands
+) {
+    if (!world.hasAllComponents<Visible, Position, Style>(entity) || !staticlayer::isStatic(world, entity)) {
+        return;
+    }
+
+    const Position& pos = world.getData<Position>(entity);
+    const Style& style = world.getData<Style>(entity);
+
+    if (world.hasComponent<Circle>(entity)) {
+        commands.push_back(rendering::circle(
+            pos.x,
+            pos.y,
+            world.getData<Circle>(entity).radius,
+            style.fillColor,
+            style.borderColor,
+            style.borderThickness
+        ));
+    }
+
+    if (world.hasComponent<Rectangle>(entity)) {
+        const Rectangle& rect = world.getData<Rectangle>(entity);
+
+        commands.push_back(rendering::rectangle(
+            pos.x,
+            pos.y,
+            rect.width,
+            rect.height,
+            style.fillColor,
+            style.borderColor,
+            style.borderThickness
+        ));
+    }
 }
 
-void renderCircles(ecs::World& world, sf::RenderWindow& window) {
+void refreshTileMaps(ecs::World& world, StaticLayer& layer) {
+    auto it = layer.tileMaps.begin();
+
+    while (it != layer.tileMaps.end()) {
+        if (world.hasAllComponents<TileMap, Visible>(it->first)) {
+            ++it;
+        } else {
+            it = layer.tileMaps.erase(it);
+        }
+    }
+
+    world.findAll<Visible>()
+        .join<TileMap>()
+        .forEach([&layer](ecs::Entity tileMapId, const TileMap& tileMap) {
+            TileMapLayer& tileMapLayer = layer.tileMaps[tileMapId];
+            unsigned batchCount = batchCountOf(tileMap);
+
+            if (tileMapLayer.batches.size() != batchCount) {
+                tileMapLayer.batches.assign(batchCount, { 0, 0, nullptr });
+                tileMapLayer.rowRevisionSums.assign(batchCount, 0);
+            }
+
+            for (unsigned i = 0; i < batchCount; i++) {
+                unsigned revisionSum = rowRevisionSum(tileMap, i);
+
+                if (tileMapLayer.rowRevisionSums[i] == revisionSum) {
+                    continue;
+                }
+
+                unsigned firstRow = i * ROWS_PER_BATCH;
+                unsigned lastRow = std::min(firstRow + ROWS_PER_BATCH, tileMap.rows);
+
+                auto commands = std::make_shared<rendering::Commands>();
+                extractTileMapRows(tileMap, firstRow, lastRow, *commands);
+
+                std::uint64_t batchId = (std::uint64_t(tileMapId) + 1) << 32 | i;
+                tileMapLayer.batches[i] = { batchId, rendering::nextRevision(), std::move(commands) };
+                tileMapLayer.rowRevisionSums[i] = revisionSum;
+            }
+        });
+}
+
+void extractTileMapRows(
+    const TileMap& tileMap,
+    unsigned firstRow,
+    unsigned lastRow,
+    rendering::Commands& commands
+) {
+    unsigned firstCell = tileMap.indexOf(0, firstRow);
+    unsigned lastCell = tileMap.indexOf(0, lastRow);
+
+    for (unsigned i = firstCell; i < lastCell; i++) {
+        if (!tileMap.isSolid(i)) {
+            continue;
+        }
+
+        const Style& style = tileMap.styleOf(i);
+        const Position center = tileMap.cellCenter(i);
+
+        commands.push_back(rendering::rectangle(
+            center.x,
+            center.y,
+            tileMap.cellWidth,
+            tileMap.cellHeight,
+            style.fillColor,
+            style.borderColor,
+            style.borderThickness
+        ));
+    }
+}
+
+void extractStaticLayer(const StaticLayer& layer, rendering::CommandList& commandList) {
+    for (const auto& [range, batch] : layer.entityBatches) {
+        commandList.staticBatches.push_back(batch);
+    }
+
+    for (const auto& [tileMapId, tileMapLayer] : layer.tileMaps) {
+        for (const rendering::StaticBatch& batch : tileMapLayer.batches) {
+            commandList.staticBatches.push_back(batch);
+        }
+    }
+}
+
+Position interpolate(
+    const ecs::World& world,
+    ecs::Entity entity,
+    const Position& pos,
+    float interpolation
+) {
+    if (!world.hasComponent<PreviousPosition>(entity)) {
+        return pos;
+    }
+
+    const PreviousPosition& previousPos = world.getData<PreviousPosition>(entity);
+
+    return Position {
+        previousPos.x + (pos.x - previousPos.x) * interpolation,
+        previousPos.y + (pos.y - previousPos.y) * interpolation
+    };
+}
+
+void extractCircles(
+    ecs::World& world,
+    rendering::Commands& commands,
+    float interpolation
+) {
     world.findAll<Visible>()
         .join<Circle>()
         .join<Position>()
         .join<Style>()
         .forEach(
-            [&window](const Circle& circle, const Position& pos, const Style& style) {
-                const sf::Color fillColor = style.fillColor;
-                const sf::Color borderColor = style.borderColor;
-                const float borderThickness = style.borderThickness;
-
-                sf::CircleShape c(circle.radius - borderThickness);
-                c.setFillColor(fillColor);
-                c.setOutlineColor(borderColor);
-                c.setOutlineThickness(borderThickness);
-                c.setPosition({
-                    pos.x + borderThickness - circle.radius,
-                    pos.y + borderThickness - circle.radius
-                });
-
-                window.draw(c);
+            [&world, &commands, interpolation](
+                ecs::Entity id,
+                const Circle& circle,
+                const Position& currentPos,
+                const Style& style
+            ) {
+                if (staticlayer::isStatic(world, id)) {
+                    return;
+                }
+
+                Position pos = interpolate(world, id, currentPos, interpolation);
+
+                commands.push_back(rendering::circle(
+                    pos.x,
+                    pos.y,
+                    circle.radius,
+                    style.fillColor,
+                    style.borderColor,
+                    style.borderThickness
+                ));
             }
         );
 }
 
-void renderRectangles(ecs::World& world, sf::RenderWindow& window) {
+void extractRectangles(
+    ecs::World& world,
+    rendering::Commands& commands,
+    float interpolation
+) {
     world.findAll<Visible>()
         .join<Rectangle>()
         .join<Position>()
         .join<Style>()
         .forEach(
-            [&window](const Rectangle& rect, const Position& pos, const Style& style) {
-                const sf::Color fillColor = style.fillColor;
-                const sf::Color borderColor = style.borderColor;
-                const float borderThickness = style.borderThickness;
-
-                sf::RectangleShape r({
-                    rect.width - 2 * borderThickness,
-                    rect.height - 2 * borderThickness
-                });
-                r.setFillColor(fillColor);
-                r.setOutlineColor(borderColor);
-                r.setOutlineThickness(borderThickness);
-                r.setPosition({
-                    pos.x + borderThickness - rect.width / 2,
-                    pos.y + borderThickness - rect.height / 2
-                });
-
-                window.draw(r);
+            [&world, &commands, interpolation](
+                ecs::Entity id,
+                const Rectangle& rect,
+                const Position& currentPos,
+                const Style& style
+            ) {
+                if (staticlayer::isStatic(world, id)) {
+                    return;
+                }
+
+                Position pos = interpolate(world, id, currentPos, interpolation);
+
+                commands.push_back(rendering::rectangle(
+                    pos.x,
+                    pos.y,
+                    rect.width,
+                    rect.height,
+                    style.fillColor,
+                    style.borderColor,
+                    style.borderThickness
+                ));
             }
         );
 }
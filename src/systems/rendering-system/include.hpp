@@ -1,6 +1,23 @@
 #pragma once
 
-#include <SFML/Graphics.hpp>
 #include "../../engine-glue/ecs.hpp"
+#include "../../engine/rendering/CommandList.hpp"
 
-void useRenderingSystem(ecs::World&, sf::RenderWindow&);
+/**
+ * Extracts the render commands of all visible entities. Static entities
+ * are emitted as cached batches, which are only rebuilt when the world
+ * reports changes to their entities (see `ecs::World::chunkRevisions`),
+ * so static entities must not be edited in place. Entities with a
+ * PreviousPosition are drawn `interpolation` of the way between it and
+ * their Position.
+ */
+void useRenderingSystem(ecs::World&, rendering::CommandList&, float interpolation);
+
+namespace staticlayer {
+    /**
+     * Whether an entity is drawn as part of the static layer rather than
+     * every frame: it isn't a ball or a paddle, which move during play even
+     * while they are at rest, and has no Input, Link or Velocity.
+     */
+    bool isStatic(const ecs::World&, ecs::Entity);
+}
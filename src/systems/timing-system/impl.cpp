@@ -1,13 +1,51 @@
 #include "include.hpp"
 
-void useTimingSystem(ecs::World& world) {
-    auto now = std::chrono::system_clock::now();
-
-    world.findAll<TimedEvent>()
-        .mutatingForEach([&world, &now](ecs::Entity id, const TimedEvent& event) {
-            if (now >= event.when) {
-                event.fn();
-                world.removeComponent<TimedEvent>(id);
+void useTimingSystem(ecs::World& world, float elapsedTime) {
+    PROFILE_SYSTEM("useTimingSystem");
+
+    auto elapsed = timing::Duration(static_cast<long>(elapsedTime * 1000000));
+
+    world.findAll<timing::Clock>()
+        .join<timing::TimerQueue>()
+        .mutatingForEach([&world, elapsed](
+            ecs::Entity queueId,
+            timing::Clock& clock,
+            const timing::TimerQueue& queue
+        ) {
+            clock.now += elapsed;
+            timing::Duration now = clock.now;
+
+            // Only takes the queue mutably when it changes, since marking it
+            // changed makes the next snapshot copy it
+            if (!queue.hasDue(now)) {
+                return;
+            }
+
+            // An event may delete the queue itself, e.g by clearing the world
+            while (world.hasComponent<timing::TimerQueue>(queueId)) {
+                auto event = world.getData<timing::TimerQueue>(queueId).popDue(now);
+
+                if (!event) {
+                    break;
+                }
+
+                if (world.hasAnyComponent(event->target)) {
+                    event->fn();
+                }
             }
         });
 }
+
+timing::TimerId scheduleEvent(
+    ecs::World& world,
+    int delayMs,
+    ecs::Entity target,
+    std::function<void()> fn
+) {
+    const ecs::World& constWorld = world;
+    ecs::Entity queueId = world.unique<timing::TimerQueue>();
+    timing::Duration now = constWorld.getData<timing::Clock>(queueId).now;
+    timing::TimerQueue& queue = world.getData<timing::TimerQueue>(queueId);
+
+    return queue.schedule(now + std::chrono::milliseconds(delayMs), target, std::move(fn));
+}
@@ -1,5 +1,17 @@
 #pragma once
 
+#include <functional>
 #include "../../engine-glue/ecs.hpp"
 
-void useTimingSystem(ecs::World&);
+void useTimingSystem(ecs::World&, float elapsedTime);
+
+/**
+ * Schedules `fn` to be called after `delayMs` of simulation time, unless
+ * `target` is deleted before that.
+ */
+timing::TimerId scheduleEvent(
+    ecs::World&,
+    int delayMs,
+    ecs::Entity target,
+    std::function<void()> fn
+);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <atomic>
+
+namespace tests {
+    /**
+     * Set by a test around the code it checks. While it is set, the calling
+     * thread's allocations are counted by the `operator new` replacement of
+     * `counting-allocation-hooks.cpp`.
+     */
+    extern thread_local bool countingAllocations;
+
+    extern std::atomic<unsigned long> allocationCount;
+}
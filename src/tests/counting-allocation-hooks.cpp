@@ -0,0 +1,32 @@
+#include <cstdlib>
+#include <new>
+#include "allocation-count.hpp"
+
+// Replacements of the global allocation functions for the tests. They live
+// in their own translation unit, so that the compiler can't inline them
+// into the callers and mistake the matching `std::free` for a mismatch.
+
+namespace tests {
+    thread_local bool countingAllocations = false;
+    std::atomic<unsigned long> allocationCount { 0 };
+}
+
+void* operator new(std::size_t size) {
+    if (tests::countingAllocations) {
+        tests::allocationCount++;
+    }
+
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
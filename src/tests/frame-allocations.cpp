@@ -0,0 +1,51 @@
+#include <iostream>
+#include "../constants.hpp"
+#include "../Game.hpp"
+#include "allocation-count.hpp"
+
+/**
+ * Checks that once warmed up, a tick of the running game performs no heap
+ * allocation, which is what the frame arena is for.
+ *
+ * The allocations of the simulation thread are counted while the measured
+ * ticks run, by the hooks of `counting-allocation-hooks.cpp`. Threads of
+ * the engine, e.g the level preparation, are not counted.
+ */
+int main() {
+    using constants::TICK_RATE;
+
+    constexpr unsigned WARM_UP_TICKS = TICK_RATE;
+    constexpr unsigned MEASURED_TICKS = TICK_RATE / 2;
+
+    // Without power-ups, no entity is created while the ball is in play
+    LevelConfig level;
+    level.powerUpDropRate = 0;
+
+    Game game;
+    game.init(level);
+
+    sf::Time tickDuration = sf::microseconds(1000000 / TICK_RATE);
+    Controls controls;
+    controls.launch = true;
+
+    for (unsigned tick = 0; tick < WARM_UP_TICKS; tick++) {
+        game.update(tickDuration, controls);
+    }
+
+    tests::countingAllocations = true;
+
+    for (unsigned tick = 0; tick < MEASURED_TICKS; tick++) {
+        game.update(tickDuration, controls);
+    }
+
+    tests::countingAllocations = false;
+
+    if (tests::allocationCount > 0) {
+        std::cerr << tests::allocationCount << " allocations in " << MEASURED_TICKS
+                  << " warmed-up ticks\n";
+        return 1;
+    }
+
+    std::cout << "no allocations in " << MEASURED_TICKS << " warmed-up ticks\n";
+    return 0;
+}
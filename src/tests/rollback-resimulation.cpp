@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "../constants.hpp"
+#include "../Game.hpp"
+#include "../helpers/level-options.hpp"
+#include "../helpers/world-hash.hpp"
+
+static Controls controlsAt(unsigned tick) {
+    using constants::TICK_RATE;
+
+    Controls controls;
+    controls.launch = true;
+    controls.left = (tick / TICK_RATE) % 2 == 0;
+    controls.right = !controls.left;
+    return controls;
+}
+
+/**
+ * Plays a level while taking a snapshot after every tick, then restores
+ * the world to the snapshot of `rollbackTick` at `currentTick` and
+ * resimulates the ticks in between with the same input, as a rollback
+ * with unchanged input would. Every resimulated tick must hash the same as
+ * the first time.
+ */
+int main() {
+    const unsigned rollbackTick = 847;
+    const unsigned currentTick = 997;
+
+    LevelConfig level;
+    parseLevelOption("--layout", "scatter", level);
+    parseLevelOption("--bricks", "400", level);
+    parseLevelOption("--balls", "3", level);
+
+    Game game;
+    game.init(level, 7);
+
+    ecs::World& world = game.getWorld();
+    world.setSnapshotCapacity(currentTick - rollbackTick + 1);
+
+    sf::Time tickDuration = sf::microseconds(1000000 / constants::TICK_RATE);
+    std::vector<std::uint64_t> hashes;
+    ecs::SnapshotId rollbackSnapshot = 0;
+
+    for (unsigned tick = 0; tick <= currentTick; tick++) {
+        game.update(tickDuration, controlsAt(tick));
+        hashes.push_back(hashWorld(world));
+        ecs::SnapshotId snapshot = world.saveSnapshot();
+
+        if (tick == rollbackTick) {
+            rollbackSnapshot = snapshot;
+        }
+    }
+
+    world.restoreSnapshot(rollbackSnapshot);
+
+    if (hashWorld(world) != hashes[rollbackTick]) {
+        std::cerr << "restored world differs from tick " << rollbackTick << '\n';
+        return 1;
+    }
+
+    for (unsigned tick = rollbackTick + 1; tick <= currentTick; tick++) {
+        game.update(tickDuration, controlsAt(tick));
+        world.saveSnapshot();
+
+        if (hashWorld(world) != hashes[tick]) {
+            std::cerr << "resimulation diverged at tick " << tick << '\n';
+            return 1;
+        }
+    }
+
+    std::cout << "resimulated " << currentTick - rollbackTick << " ticks\n";
+    return 0;
+}